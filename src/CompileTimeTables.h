@@ -0,0 +1,129 @@
+// (c) 2025 Patricio Palma (ppalma.dev AT protonmail.com)
+//
+// Lookup tables that can be built by the compiler or at startup: a CRC32 table, sorted keywords, a perfect hash of
+// the same keywords and the primes below a limit. Used by Cpp20Features and by the compile_time_table sources the
+// build compiles to measure what each table costs the compiler.
+
+#ifndef COMPILETIMETABLES_H
+#define COMPILETIMETABLES_H
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+// A constexpr function can run at compile time or at run time, the caller decides. The same code builds the
+// compile time tables and their runtime initialized twins.
+constexpr std::array<std::uint32_t, 256> make_crc32_table(const std::uint32_t polynomial)
+{
+    std::array<std::uint32_t, 256> table{};
+    for (std::uint32_t i = 0; i < table.size(); ++i)
+    {
+        auto crc = i;
+        for (int bit = 0; bit < 8; ++bit)
+        {
+            crc = (crc & 1) ? polynomial ^ (crc >> 1) : crc >> 1;
+        }
+        table[i] = crc;
+    }
+    return table;
+}
+
+inline std::uint32_t crc32(const std::array<std::uint32_t, 256>& table, const std::vector<std::uint8_t>& data)
+{
+    std::uint32_t crc = 0xFFFFFFFFu;
+    for (const auto byte : data)
+    {
+        crc = table[(crc ^ byte) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+inline constexpr std::array<std::string_view, 32> keywords = {
+    "alignas", "auto", "bool", "break", "case", "catch", "char", "class", "const", "constexpr", "continue",
+    "default", "delete", "do", "double", "else", "enum", "explicit", "false", "float", "for", "if", "inline",
+    "int", "namespace", "new", "return", "static", "struct", "switch", "template", "void"};
+
+// C++20 consteval
+// An immediate function, every call must produce a constant. std::ranges::sort is constexpr since C++20.
+consteval auto sorted_keywords()
+{
+    auto sorted = keywords;
+    std::ranges::sort(sorted);
+    return sorted;
+}
+
+inline constexpr std::size_t keyword_slots = 128;
+
+// FNV-1a, the slot comes from the high bits as the multiplications only carry the low bits upwards.
+constexpr std::size_t keyword_slot(const std::string_view word, const std::uint32_t seed)
+{
+    std::uint32_t hash = 2166136261u ^ seed;
+    for (const char c : word)
+    {
+        hash = (hash ^ static_cast<unsigned char>(c)) * 16777619u;
+    }
+    return static_cast<std::size_t>((std::uint64_t{hash} * keyword_slots) >> 32);
+}
+
+struct keyword_table
+{
+    std::uint32_t seed;
+    std::array<std::string_view, keyword_slots> slots;
+};
+
+// Tries seeds from first_seed on until every keyword lands in its own slot: a perfect hash, a lookup is one hash and
+// one compare.
+constexpr keyword_table find_perfect_keyword_table(const std::uint32_t first_seed)
+{
+    for (std::uint32_t seed = first_seed; ; ++seed)
+    {
+        keyword_table table{seed, {}};
+        const bool collision_free = std::ranges::all_of(keywords, [&](const std::string_view word)
+        {
+            auto& slot = table.slots[keyword_slot(word, seed)];
+            return slot.empty() && !(slot = word).empty();
+        });
+        if (collision_free)
+        {
+            return table;
+        }
+    }
+}
+
+// The search runs in the compiler, if no seed worked the build would fail instead of the program.
+consteval keyword_table perfect_keyword_table()
+{
+    return find_perfect_keyword_table(0);
+}
+
+#if defined(__cpp_lib_constexpr_vector)
+// C++20 constexpr std::vector
+// Memory allocated during constant evaluation must be freed before it ends, so a std::vector cannot be the
+// result. It can still do the work: one call sizes the std::array, a second one fills it.
+constexpr std::vector<int> primes_below(const int limit)
+{
+    std::vector<char> composite(static_cast<std::size_t>(limit), 0);
+    std::vector<int> primes;
+    for (int i = 2; i < limit; ++i)
+    {
+        if (composite[i]) continue;
+        primes.push_back(i);
+        for (int multiple = i * i; multiple < limit; multiple += i) composite[multiple] = 1;
+    }
+    return primes;
+}
+
+inline constexpr int prime_limit = 10'000;
+
+consteval auto prime_table()
+{
+    std::array<int, primes_below(prime_limit).size()> table{};
+    std::ranges::copy(primes_below(prime_limit), table.begin());
+    return table;
+}
+#endif
+
+#endif //COMPILETIMETABLES_H
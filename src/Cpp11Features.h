@@ -6,13 +6,22 @@
 
 #ifndef CPP11FEATURES_H
 #define CPP11FEATURES_H
+#include <algorithm>
 #include <array>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
 #include <future>
 #include <mutex>
 #include <numeric>
+#include <queue>
+#include <ranges>
 #include <thread>
 #include <vector>
 #include "CppFeatures.h"
+#include "ThreadPlacement.h"
+#include "ThreadPool.h"
+#include "Tracing.h"
 #include "Utilities.h"
 
 // TODO: Pending C++11 features
@@ -32,10 +41,14 @@ class Cpp11Features final : public CppFeatures
     int x = 1;
     int y = 1;
 
+    // Where the threads of the threaded sections run.
+    thread_placement placement = thread_placement::os_default;
+
 public:
     // C++11 delegating constructors.
     // This constructor reuses the logic in the custom default constructor while adds more logic.
-    Cpp11Features() : CppFeatures("C++11")
+    explicit Cpp11Features(const thread_placement aPlacement = thread_placement::os_default)
+        : CppFeatures("C++11"), placement(aPlacement)
     {
         // C++11 keyword "constexpr"
         constexpr auto p = 10;
@@ -63,8 +76,11 @@ public:
         smart_pointers();
         threads();
         locks();
+        placement_cost();
         futures();
+        futures_fan_out();
         promise();
+        trace_overhead();
     }
 
 private:
@@ -100,6 +116,7 @@ private:
 
     static void thread_payload()
     {
+        trace_zone zone(__func__);
         std::cout << "Member function payload started.\n";
     }
 
@@ -107,6 +124,7 @@ private:
     {
         void operator()() const
         {
+            trace_zone zone("thread_functor");
             std::cout << "Functor payload started.\n";
         }
     };
@@ -114,23 +132,29 @@ private:
     void threads() const
     {
         print_title(__func__);
+        trace_zone zone(__func__);
 
         // C++11 instantiate a thread with static member function as payload
-        std::thread memberFunctionThread(Cpp11Features::thread_payload);
+        std::thread memberFunctionThread(placed(placement, 0, Cpp11Features::thread_payload));
 
         // C++11 wait for the thread to join (to finish) to continue.
         memberFunctionThread.join();
 
-        std::thread functorThread{thread_functor()};
+        std::thread functorThread{placed(placement, 1, thread_functor())};
         functorThread.join();
 
-        std::thread lambdaThread{[]{ std::cout << "Lambda payload started.\n";}};
+        std::thread lambdaThread{placed(placement, 2, []
+        {
+            trace_zone zone("thread lambda");
+            std::cout << "Lambda payload started.\n";
+        })};
         lambdaThread.join();
     }
 
     void locks() const
     {
         print_title(__func__);
+        trace_zone zone(__func__);
 
         // C++11 std::mutex
         // This will control access to counter variable.
@@ -140,9 +164,11 @@ private:
         // Threads will increase an external counter on the value of the delta provided
         auto payload = [&mutex](int& counter, const int delta)
         {
+          trace_zone zone("locks payload");
           for (int i = 0; i<5; ++i)
           {
               std::lock_guard<std::mutex> g(mutex);
+              trace_zone locked("locked");
               counter += delta;
               std::cout << "delta=" << delta << " counter=" << counter << '\n';
           }
@@ -157,7 +183,7 @@ private:
         {
             // std::ref is required when passing references to a thread payload, as payload
             // arguments are copied into the thread storage area.
-            threads[i] = std::thread(payload, std::ref(counter), i+1);
+            threads[i] = std::thread(placed(placement, i, payload), std::ref(counter), i+1);
         }
 
         // wait for all threads to finish.
@@ -167,6 +193,82 @@ private:
         std::cout << "outer counter=" << counter << '\n';
     }
 
+    // Two threads talking through a shared cache line: a contended std::atomic counter and a std::mutex
+    // protected queue. The cost depends on where the threads run relative to each other.
+    void placement_cost() const
+    {
+        print_title(__func__);
+
+        const auto topology = cpu_topology();
+        auto relation = [&topology](const int a, const int b) -> std::string
+        {
+            const auto find = [&](const int id) { return *std::ranges::find(topology, id, &logical_cpu::id); };
+            const auto ca = find(a);
+            const auto cb = find(b);
+            if (a == b) return "same cpu";
+            if (ca.package != cb.package) return "cross socket";
+            return ca.core == cb.core ? "smt siblings" : "cross core";
+        };
+
+        for (const auto policy : {thread_placement::same_cpu, thread_placement::smt_siblings, thread_placement::spread})
+        {
+            constexpr int operations = 200'000;
+
+            // C++11 std::atomic
+            // Both threads increment the same counter, the cache line moves between them on every increment.
+            std::atomic<int> counter{0};
+            const auto counter_time = measure([&]
+            {
+                auto payload = [&counter] { for (int i = 0; i < operations; ++i) counter.fetch_add(1); };
+                std::thread a(placed(policy, 0, payload));
+                std::thread b(placed(policy, 1, payload));
+                a.join();
+                b.join();
+            });
+
+            // Producer/consumer over a std::queue guarded by a std::mutex and a std::condition_variable.
+            std::mutex mutex;
+            std::condition_variable ready;
+            std::queue<int> queue;
+            long long consumed = 0;
+            const auto queue_time = measure([&]
+            {
+                std::thread producer(placed(policy, 0, [&]
+                {
+                    for (int i = 0; i < operations; ++i)
+                    {
+                        {
+                            std::lock_guard<std::mutex> g(mutex);
+                            queue.push(i);
+                        }
+                        ready.notify_one();
+                    }
+                }));
+                std::thread consumer(placed(policy, 1, [&]
+                {
+                    for (int received = 0; received < operations; )
+                    {
+                        std::unique_lock<std::mutex> lock(mutex);
+                        ready.wait(lock, [&queue] { return !queue.empty(); });
+                        for (; !queue.empty(); queue.pop(), ++received)
+                        {
+                            consumed += queue.front();
+                        }
+                    }
+                }));
+                producer.join();
+                consumer.join();
+            });
+
+            const int cpu_a = cpu_for(policy, 0);
+            const int cpu_b = cpu_for(policy, 1);
+            std::cout << to_string(policy) << " cpus=" << cpu_a << "," << cpu_b << " (" << relation(cpu_a, cpu_b) << ")"
+                      << " atomic counter=" << counter_time.count() / (2 * operations) << "ns/op"
+                      << " queue=" << queue_time.count() / operations << "ns/item"
+                      << " counter=" << counter << " consumed=" << consumed << '\n';
+        }
+    }
+
     void smart_pointers()
     {
         print_title(__func__);
@@ -214,6 +316,7 @@ private:
 
     [[nodiscard]] float futures_payload(const int i) const
     {
+        trace_zone zone(__func__);
         std::cout << "Futures payload started. i=" << i << '\n';
         std::this_thread::sleep_for(std::chrono::milliseconds(200));
         return static_cast<float>(i)  * 0.79f;
@@ -222,6 +325,7 @@ private:
     void futures() const
     {
         print_title(__func__);
+        trace_zone zone(__func__);
 
         // C++11 std::async/std::future provides a mechanism to execute asynchronous task potentially
         // as a new thread, that is up to the std::launch policy defined.
@@ -236,6 +340,7 @@ private:
         std::future<float> asyncTask2 = std::async(std::launch::deferred, &Cpp11Features::futures_payload, this, 2);
 
         std::future<int> asyncTask3 = std::async([](){
+            trace_zone zone("futures lambda");
             std::cout << "Lambda payload started.\n";
             return 7;
         });
@@ -245,9 +350,174 @@ private:
         std::cout << "asyncTask3=" << asyncTask3.get() << '\n';
     }
 
+    // Continuation style fan-in, like the proposed std::when_all: the task that finishes last completes the returned
+    // future, no thread blocks on the individual results. The first exception, if any, is delivered instead.
+    template <typename Callable>
+    static std::future<std::vector<std::invoke_result_t<Callable&>>> when_all(thread_pool& pool, std::vector<Callable> tasks)
+    {
+        using result = std::invoke_result_t<Callable&>;
+        struct state
+        {
+            std::vector<result> results;
+            std::atomic<std::size_t> pending;
+            std::atomic<bool> failed{false};
+            std::promise<std::vector<result>> done;
+        };
+        auto shared = std::make_shared<state>();
+        shared->results.resize(tasks.size());
+        shared->pending = tasks.size();
+        auto all = shared->done.get_future();
+        for (std::size_t i = 0; i < tasks.size(); ++i)
+        {
+            pool.submit([shared, i, task = std::move(tasks[i])]() mutable
+            {
+                try
+                {
+                    shared->results[i] = task();
+                }
+                catch (...)
+                {
+                    if (!shared->failed.exchange(true)) shared->done.set_exception(std::current_exception());
+                }
+                if (shared->pending.fetch_sub(1, std::memory_order_acq_rel) == 1 && !shared->failed)
+                {
+                    shared->done.set_value(std::move(shared->results));
+                }
+            });
+        }
+        return all;
+    }
+
+    // Fan-out of tasks, fan-in of their results, from empty tasks to 100us of work each. Every way of launching
+    // them is timed end to end many times, and compared with calling the tasks one after the other: the break even
+    // is the smallest task for which it is faster than that.
+    void futures_fan_out() const
+    {
+        print_title(__func__);
+
+        constexpr std::size_t tasks_count = 64;
+        using work_time = std::chrono::nanoseconds;
+        // busy work for the given time, returns something for the fan-in to add up
+        auto work = [](const work_time duration)
+        {
+            std::size_t spins = 1;
+            for (const auto end = std::chrono::steady_clock::now() + duration; std::chrono::steady_clock::now() < end; ) ++spins;
+            return spins;
+        };
+
+        // not traced, none of the other approaches pays for trace zones either
+        thread_pool pool(std::max(1u, std::thread::hardware_concurrency()), placement, false);
+        const std::vector<std::pair<const char*, std::function<std::size_t(work_time)>>> approaches = {
+            {"sequential", [&](const work_time w)
+            {
+                std::size_t sum = 0;
+                for (std::size_t t = 0; t < tasks_count; ++t) sum += work(w);
+                return sum;
+            }},
+            // C++11 std::async, a new thread per task
+            {"async", [&](const work_time w)
+            {
+                std::vector<std::future<std::size_t>> results;
+                for (std::size_t t = 0; t < tasks_count; ++t) results.push_back(std::async(std::launch::async, work, w));
+                std::size_t sum = 0;
+                for (auto& r : results) sum += r.get();
+                return sum;
+            }},
+            // runs each task in get(), on this thread
+            {"deferred", [&](const work_time w)
+            {
+                std::vector<std::future<std::size_t>> results;
+                for (std::size_t t = 0; t < tasks_count; ++t) results.push_back(std::async(std::launch::deferred, work, w));
+                std::size_t sum = 0;
+                for (auto& r : results) sum += r.get();
+                return sum;
+            }},
+            // C++11 std::packaged_task, one per task, queued to the pool
+            {"pool", [&](const work_time w)
+            {
+                std::vector<std::future<std::size_t>> results;
+                for (std::size_t t = 0; t < tasks_count; ++t) results.push_back(pool.submit([&work, w] { return work(w); }));
+                std::size_t sum = 0;
+                for (auto& r : results) sum += r.get();
+                return sum;
+            }},
+            {"when_all", [&](const work_time w)
+            {
+                auto all = when_all(pool, std::vector(tasks_count, std::function<std::size_t()>([&work, w] { return work(w); })));
+                const auto results = all.get();
+                return std::accumulate(results.begin(), results.end(), std::size_t{0});
+            }},
+            // one pool task per worker, each running an equal share of the tasks
+            {"batched", [&](const work_time w)
+            {
+                std::vector<std::future<std::size_t>> results;
+                for (std::size_t b = 0; b < pool.size(); ++b)
+                {
+                    results.push_back(pool.submit([&work, w, first = tasks_count * b / pool.size(), last = tasks_count * (b + 1) / pool.size()]
+                    {
+                        std::size_t batch = 0;
+                        for (auto t = first; t < last; ++t) batch += work(w);
+                        return batch;
+                    }));
+                }
+                std::size_t sum = 0;
+                for (auto& r : results) sum += r.get();
+                return sum;
+            }},
+        };
+
+        using namespace std::chrono_literals;
+        const std::vector<work_time> granularities = {0ns, 1us, 10us, 100us};
+        std::vector<std::vector<double>> p50(approaches.size());
+        std::vector<std::vector<double>> p90(approaches.size());
+        for (const auto granularity : granularities)
+        {
+            // about 20ms of sequential work per approach, between 20 and 200 fan-outs
+            const auto fan_outs = std::clamp<std::size_t>(20ms / std::max<work_time>(1ns, granularity * tasks_count), 20, 200);
+            for (std::size_t a = 0; a < approaches.size(); ++a)
+            {
+                std::vector<double> latencies;
+                std::size_t sum = 0;
+                for (std::size_t f = 0; f < fan_outs; ++f)
+                {
+                    latencies.push_back(static_cast<double>(measure([&] { sum += approaches[a].second(granularity); }).count()) / 1000.0);
+                }
+                do_not_optimize(sum);
+                std::ranges::sort(latencies);
+                const auto percentile = [&](const std::size_t p) { return latencies[std::min(latencies.size() - 1, latencies.size() * p / 100)]; };
+                p50[a].push_back(percentile(50));
+                p90[a].push_back(percentile(90));
+                std::cout << tasks_count << " tasks of " << granularity.count() << "ns " << approaches[a].first
+                          << ": p50=" << percentile(50) << "us p90=" << percentile(90) << "us p99=" << percentile(99) << "us\n";
+            }
+        }
+
+        // Faster only counts when the p50 gap is larger than the p90 - p50 spread of either side, not noise.
+        const auto faster = [&](const std::size_t a, const std::size_t g)
+        {
+            const auto spread = std::max(p90[a][g] - p50[a][g], p90[0][g] - p50[0][g]);
+            return p50[0][g] - p50[a][g] > spread;
+        };
+        for (std::size_t a = 1; a < approaches.size(); ++a)
+        {
+            const auto even = std::ranges::find_if(std::views::iota(std::size_t{0}, granularities.size()),
+                                                   [&](const std::size_t g) { return faster(a, g); });
+            std::cout << approaches[a].first << " breaks even with sequential calls ";
+            if (*even == granularities.size())
+            {
+                std::cout << "at none of the task sizes (" << pool.size() << " pool threads)\n";
+            }
+            else
+            {
+                std::cout << "from " << granularities[*even].count() << "ns tasks\n";
+            }
+        }
+    }
+
     void promiseWorkerImplementation(const std::vector<std::string>::const_iterator begin,
                                const std::vector<std::string>::const_iterator end, std::promise<std::string> thePromise) const
     {
+        trace_zone zone(__func__);
         using namespace std::string_literals;
         auto sep = [](const std::string& a, const std::string& b) {
             return a + "-" + b;
@@ -258,6 +528,7 @@ private:
 
     void promise() const
     {
+        trace_zone zone(__func__);
         // C++11 std::promise
         // This is a shared state provider, this state contains the result accessed by std::future.
         // std::async is a high level convenience that creates the state provider, the state and the result object.
@@ -270,13 +541,48 @@ private:
 
         // launch the task (simulate std::async)
         const std::vector<std::string> severalStrings = {"the", "quick", "brown", "fox","jumped", "over", "the", "lazy", "dog "};
-        std::thread workerThread(&Cpp11Features::promiseWorkerImplementation, this,  severalStrings.cbegin(), severalStrings.cend(), std::move(thePromise));
+        std::thread workerThread(placed(placement, 0, &Cpp11Features::promiseWorkerImplementation), this,  severalStrings.cbegin(), severalStrings.cend(), std::move(thePromise));
         // thePromise do not lives here anymore.
 
         std::cout << "theFuture=" << theFuture.get() << '\n';
         // While execution stopped in theFuture.get(), join() still needs to be called (and avoid a crashing) (use jthread if possible).
         workerThread.join();
     }
+
+    // Cost of one zone (the thread buffer lookup, two clock reads and one store). The zones go to a scratch buffer
+    // that is not registered, so they stay out of the exported timeline. Every thread fills exactly its first chunk,
+    // so no chunk is allocated while measuring.
+    void trace_overhead() const
+    {
+        print_title(__func__);
+
+        constexpr int zones = trace_buffer::chunk_capacity;
+        constexpr int threads_count = 4;
+        std::array<std::chrono::nanoseconds, threads_count> elapsed{};
+        std::array<std::thread, threads_count> threads;
+        for (int i = 0; i < threads_count; ++i)
+        {
+            threads[i] = std::thread(placed(placement, i, [&elapsed, i]
+            {
+                trace_buffer scratch(0);
+                this_thread_trace_buffer(); // registration is a one time cost, keep it out of the measurement
+                elapsed[i] = measure([&scratch]
+                {
+                    for (int z = 0; z < zones; ++z)
+                    {
+                        do_not_optimize(&this_thread_trace_buffer());
+                        trace_zone zone(scratch, "overhead");
+                    }
+                });
+            }));
+        }
+        for (auto& thread : threads) { thread.join(); }
+
+        for (int i = 0; i < threads_count; ++i)
+        {
+            std::cout << "thread " << i << " " << elapsed[i].count() / zones << "ns per zone\n";
+        }
+    }
 };
 
 #endif //CPP11FEATURES_H
@@ -9,8 +9,13 @@
 #include <any>
 #include <filesystem>
 #include <optional>
+#include <random>
+#include <string>
 #include <variant>
+#include <vector>
 #include "CppFeatures.h"
+#include "Symbols.h"
+#include "Utilities.h"
 
 class Cpp17Features final : public CppFeatures
 {
@@ -19,12 +24,14 @@ public:
     void show_features() override
     {
         structured_binding();
+        data_layout();
         nodiscard_attribute();
         std_optional();
         std_variant();
         if_switch_initializers();
         std_any();
         std_string_view();
+        string_interning();
         std_filesystem();
     }
 
@@ -63,6 +70,168 @@ private:
         }
     }
 
+    // The records of sb_test_struct as a struct of arrays (SoA), one vector per field. A scan that only needs one
+    // field reads only that vector, instead of dragging the other fields through the cache.
+    struct sb_test_columns
+    {
+        std::vector<int> a;
+        std::vector<std::string> b;
+        std::vector<char> c; // std::vector<bool> packs bits and cannot hand out a bool&
+
+        // A record is a proxy holding a reference to each field, so structured bindings work the same way they do
+        // with sb_test_struct and writes through the bindings reach the columns.
+        struct reference
+        {
+            int& a;
+            std::string& b;
+            char& c;
+        };
+
+        struct iterator
+        {
+            sb_test_columns* columns;
+            std::size_t i;
+            reference operator*() const { return (*columns)[i]; }
+            iterator& operator++() { ++i; return *this; }
+            bool operator==(const iterator&) const = default;
+        };
+
+        void push_back(const sb_test_struct& record)
+        {
+            a.push_back(record.a);
+            b.push_back(record.b);
+            c.push_back(record.c);
+        }
+        [[nodiscard]] std::size_t size() const { return a.size(); }
+        reference operator[](const std::size_t i) { return {a[i], b[i], c[i]}; }
+        iterator begin() { return {this, 0}; }
+        iterator end() { return {this, size()}; }
+    };
+
+    // Hybrid array of structs of arrays (AoSoA): blocks of lanes records stored as small SoA. Inside a block the
+    // fields are contiguous as in SoA, while all the fields of a record stay close in memory as in AoS.
+    template <std::size_t lanes>
+    struct sb_test_blocks
+    {
+        struct block
+        {
+            int a[lanes];
+            std::string b[lanes];
+            char c[lanes];
+        };
+
+        void push_back(const sb_test_struct& record)
+        {
+            if (count % lanes == 0)
+            {
+                blocks.emplace_back();
+            }
+            auto& last = blocks.back();
+            last.a[count % lanes] = record.a;
+            last.b[count % lanes] = record.b;
+            last.c[count % lanes] = record.c;
+            ++count;
+        }
+
+        std::vector<block> blocks;
+        std::size_t count = 0;
+    };
+
+    void data_layout() const
+    {
+        print_title(__func__);
+
+        constexpr std::size_t records = 1 << 20;
+        constexpr std::size_t lanes = 16;
+        // the records fill whole blocks, so the AoSoA loops below do not deal with a partial last block
+        static_assert(records % lanes == 0);
+        std::vector<sb_test_struct> rows; // array of structs (AoS)
+        sb_test_columns columns;
+        sb_test_blocks<lanes> blocks;
+        rows.reserve(records);
+        for (std::size_t i = 0; i < records; ++i)
+        {
+            const sb_test_struct record{static_cast<int>(i % 1000), "id" + std::to_string(i % 10'000), i % 3 == 0};
+            rows.push_back(record);
+            columns.push_back(record);
+            blocks.push_back(record);
+        }
+
+        // structured bindings over the SoA proxy, writes go to the columns
+        for (auto [a, b, c] : columns)
+        {
+            a += 1;
+        }
+        for (auto& row : rows) { row.a += 1; }
+        for (auto& block : blocks.blocks) { for (auto& a : block.a) a += 1; }
+        {
+            const auto [a, b, c] = columns[7];
+            std::cout << "columns[7] a=" << a << " b=" << b << " c=" << static_cast<bool>(c) << '\n';
+        }
+
+        auto report = [](const char* workload, auto&& aos, auto&& soa, auto&& aosoa)
+        {
+            long long results[3] = {};
+            const auto aos_time = measure([&] { results[0] = aos(); });
+            const auto soa_time = measure([&] { results[1] = soa(); });
+            const auto aosoa_time = measure([&] { results[2] = aosoa(); });
+            std::cout << workload << ": AoS=" << to_ms(aos_time) << "ms SoA=" << to_ms(soa_time) << "ms AoSoA="
+                      << to_ms(aosoa_time) << "ms result=" << results[0] << " same result="
+                      << (results[0] == results[1] && results[1] == results[2] ? "true" : "false") << '\n';
+        };
+
+        // Reads one field out of three
+        report("sum(a)",
+            [&] { long long sum = 0; for (const auto& [a, b, c] : rows) sum += a; return sum; },
+            [&] { long long sum = 0; for (const int a : columns.a) sum += a; return sum; },
+            [&]
+            {
+                long long sum = 0;
+                for (const auto& block : blocks.blocks) for (const int a : block.a) sum += a;
+                return sum;
+            });
+
+        // Reads two fields out of three
+        report("sum(a) where c",
+            [&] { long long sum = 0; for (const auto& [a, b, c] : rows) sum += c ? a : 0; return sum; },
+            [&]
+            {
+                long long sum = 0;
+                for (std::size_t i = 0; i < columns.size(); ++i) sum += columns.c[i] ? columns.a[i] : 0;
+                return sum;
+            },
+            [&]
+            {
+                long long sum = 0;
+                for (const auto& block : blocks.blocks)
+                    for (std::size_t i = 0; i < lanes; ++i) sum += block.c[i] ? block.a[i] : 0;
+                return sum;
+            });
+
+        // Reads every field, the case where AoS does not lose
+        report("sum(a + b.size()) where c",
+            [&]
+            {
+                long long sum = 0;
+                for (const auto& [a, b, c] : rows) sum += c ? a + static_cast<long long>(b.size()) : 0;
+                return sum;
+            },
+            [&]
+            {
+                long long sum = 0;
+                for (auto [a, b, c] : columns) sum += c ? a + static_cast<long long>(b.size()) : 0;
+                return sum;
+            },
+            [&]
+            {
+                long long sum = 0;
+                for (const auto& block : blocks.blocks)
+                    for (std::size_t i = 0; i < lanes; ++i)
+                        sum += block.c[i] ? block.a[i] + static_cast<long long>(block.b[i].size()) : 0;
+                return sum;
+            });
+    }
+
     [[nodiscard]] int nodiscard_attribute_impl() const
     {
         return 0;
@@ -222,6 +391,72 @@ private:
                   << "string view=" << v << '\n';
     }
 
+    // Millions of short ids, as kept by an in-memory index, stored as std::string, as interned symbols and as
+    // inline_string. Short texts fit in the std::string small buffer, the cost there is its 32 bytes per id.
+    void string_interning() const
+    {
+        print_title(__func__);
+
+        constexpr std::size_t ids = 2'000'000;
+        constexpr std::size_t distinct = 100'000;
+        std::vector<std::string> names;
+        for (std::size_t i = 0; i < distinct; ++i)
+        {
+            names.push_back("sensor-" + std::to_string(i * 7919 % 1'000'000)); // up to 13 characters
+        }
+        std::mt19937 generator(7);
+        std::uniform_int_distribution<std::size_t> pick(0, distinct - 1);
+        std::vector<std::size_t> picks(ids);
+        for (auto& p : picks) { p = pick(generator); }
+
+        // extra_bytes() is memory held outside the vector, asked for once the ids exist
+        auto report = [&](const char* type, auto& values, auto&& create, auto&& extra_bytes)
+        {
+            const auto creation = measure([&] { for (const auto p : picks) values.push_back(create(names[p])); });
+            std::size_t equal = 0;
+            const auto comparison = measure([&]
+            {
+                for (std::size_t i = 1; i < values.size(); ++i) equal += values[i] == values[i - 1];
+            });
+            std::size_t hashes = 0;
+            const auto hashing = measure([&]
+            {
+                for (const auto& value : values) hashes += std::hash<std::decay_t<decltype(value)>>{}(value);
+            });
+            do_not_optimize(hashes);
+            const auto bytes = values.capacity() * sizeof(values[0]) + extra_bytes();
+            std::cout << type << ": create=" << to_ms(creation) << "ms compare=" << to_ms(comparison) << "ms hash="
+                      << to_ms(hashing) << "ms memory=" << bytes / 1024 << "KB (" << sizeof(values[0])
+                      << " bytes per id) equal neighbours=" << equal << '\n';
+        };
+
+        std::vector<std::string> strings;
+        strings.reserve(ids);
+        report("std::string", strings, [](const std::string& name) { return name; }, [&]
+        {
+            // only texts longer than the small buffer allocate
+            std::size_t heap = 0;
+            for (const auto& s : strings) { heap += s.capacity() > std::string().capacity() ? s.capacity() + 1 : 0; }
+            return heap;
+        });
+
+        symbol_table table;
+        std::vector<symbol> symbols;
+        symbols.reserve(ids);
+        report("symbol", symbols, [&](const std::string& name) { return table.intern(name); },
+               [&] { return table.memory_bytes(); });
+        std::cout << "symbol table: " << table.size() << " texts, " << table.memory_bytes() / 1024 << "KB\n";
+
+        std::vector<inline_string<15>> inline_strings;
+        inline_strings.reserve(ids);
+        report("inline_string<15>", inline_strings, [](const std::string& name) { return inline_string<15>(name); },
+               [] { return std::size_t{0}; });
+
+        const auto a = table.intern("sensor-7919");
+        const auto b = table.intern(std::string("sensor-") + "7919");
+        std::cout << a << " and " << b << " interned twice are the same symbol: " << (a == b) << '\n';
+    }
+
     void std_filesystem() const
     {
         print_title(__func__);
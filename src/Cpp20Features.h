@@ -7,19 +7,51 @@
 #ifndef CPP20FEATURES_H
 #define CPP20FEATURES_H
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <barrier>
+#include <condition_variable>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <latch>
+#include <mutex>
+#include <numeric>
+#include <random>
 #include <ranges>
+#include <semaphore>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "CompileTimeTables.h"
 #include "CppFeatures.h"
+#include "FlatHashMap.h"
+#include "ThreadPlacement.h"
+#include "Tracing.h"
+#include "Utilities.h"
+#if __has_include("CompileTimeTableCosts.h")
+#include "CompileTimeTableCosts.h"
+#endif
 
 class Cpp20Features final : public CppFeatures
 {
 public:
-    Cpp20Features() : CppFeatures("C++20") { }
+    explicit Cpp20Features(const thread_placement aPlacement = thread_placement::os_default)
+        : CppFeatures("C++20"), placement(aPlacement) { }
     void show_features() override
     {
         std_ranges_and_std_views();
+        open_addressing_hash_map();
+        synchronization_primitives();
+        compile_time_tables();
     }
 
 private:
+    thread_placement placement;
+
     void std_ranges_and_std_views() const
     {
         print_title(__func__);
@@ -47,6 +79,355 @@ private:
         // How operator| works? How an array is constructed using iota and take.
 
     }
+
+    // Time per operation and bytes per element: insert all the keys, look up keys that are there (hits) and keys
+    // that are not (misses), then erase all the keys.
+    template <typename Map, typename Key, typename Lookup>
+    static void hash_map_cost(const std::string_view name, Map& map, const std::vector<Key>& keys,
+                              const std::vector<Lookup>& hits, const std::vector<Lookup>& misses, auto&& memory_bytes)
+    {
+        const auto n = static_cast<long long>(keys.size());
+        int value = 0;
+        std::size_t found = 0;
+        const auto insert = measure([&] { for (const auto& key : keys) map.emplace(key, value++); });
+        const auto bytes = memory_bytes();
+        const auto hit = measure([&] { for (const auto& key : hits) found += map.contains(key); });
+        const auto miss = measure([&] { for (const auto& key : misses) found += map.contains(key); });
+        const auto erase = measure([&] { for (const auto& key : keys) map.erase(key); });
+        std::cout << name << ": insert=" << insert.count() / n << "ns hit=" << hit.count() / n
+                  << "ns miss=" << miss.count() / n << "ns erase=" << erase.count() / n
+                  << "ns bytes/element=" << bytes / keys.size() << " found=" << found << '\n';
+    }
+
+    void open_addressing_hash_map() const
+    {
+        print_title(__func__);
+
+        // std::unordered_map allocates a node per element and chains the nodes of a bucket, a lookup follows at least
+        // one pointer to memory that is likely not in cache. flat_hash_map (FlatHashMap.h) keeps the elements in one
+        // array and filters the candidates of 16 slots at once with their control bytes.
+        constexpr std::size_t count = 1 << 19;
+        std::mt19937 generator(3);
+
+        {
+            // even keys are inserted, odd keys are the misses
+            std::vector<int> keys(count);
+            std::vector<int> misses(count);
+            std::ranges::generate(keys, [i = 0]() mutable { return 2 * i++; });
+            std::ranges::generate(misses, [i = 0]() mutable { return 2 * i++ + 1; });
+            std::ranges::shuffle(keys, generator);
+            std::ranges::shuffle(misses, generator);
+            auto hits = keys;
+            std::ranges::shuffle(hits, generator);
+
+            std::size_t allocated = 0;
+            std::unordered_map<int, int, std::hash<int>, std::equal_to<int>, counting_allocator<std::pair<const int, int>>>
+                node_map(0, std::hash<int>{}, std::equal_to<int>{}, counting_allocator<std::pair<const int, int>>(allocated));
+            hash_map_cost("int keys std::unordered_map", node_map, keys, hits, misses, [&] { return allocated; });
+
+            flat_hash_map<int, int> flat_map;
+            hash_map_cost("int keys flat_hash_map     ", flat_map, keys, hits, misses, [&] { return flat_map.memory_bytes(); });
+        }
+        {
+            // short identifiers, the lookups are std::string_view thanks to the transparent hash and equality
+            std::vector<std::string> keys(count);
+            std::vector<std::string> absent(count);
+            std::ranges::generate(keys, [i = 0]() mutable { return "user-" + std::to_string(i++); });
+            std::ranges::generate(absent, [i = 0]() mutable { return "item-" + std::to_string(i++); });
+            std::ranges::shuffle(keys, generator);
+            std::vector<std::string_view> hits(keys.begin(), keys.end());
+            std::vector<std::string_view> misses(absent.begin(), absent.end());
+            std::ranges::shuffle(hits, generator);
+
+            using node_allocator = counting_allocator<std::pair<const std::string, int>>;
+            std::size_t allocated = 0;
+            std::unordered_map<std::string, int, string_hash, std::equal_to<>, node_allocator>
+                node_map(0, string_hash{}, std::equal_to<>{}, node_allocator(allocated));
+            hash_map_cost("string keys std::unordered_map", node_map, keys, hits, misses, [&] { return allocated; });
+
+            flat_hash_map<std::string, int, string_hash, std::equal_to<>> flat_map;
+            hash_map_cost("string keys flat_hash_map     ", flat_map, keys, hits, misses, [&] { return flat_map.memory_bytes(); });
+
+            // a std::string_view or a literal finds a std::string key without a temporary std::string
+            flat_map.emplace("user-7", 7);
+            std::cout << "flat_map.find(\"user-7\")=" << *flat_map.find(std::string_view("user-7")) << '\n';
+        }
+    }
+
+    // A reusable barrier made of C++11 primitives, this is what we had to write before std::barrier.
+    class condvar_barrier
+    {
+    public:
+        explicit condvar_barrier(const std::ptrdiff_t expected) : expected_count(expected), remaining(expected) { }
+
+        void arrive_and_wait()
+        {
+            std::unique_lock lock(mutex);
+            const auto arrival_generation = generation;
+            if (--remaining == 0)
+            {
+                ++generation;
+                remaining = expected_count;
+                cv.notify_all();
+                return;
+            }
+            cv.wait(lock, [&] { return generation != arrival_generation; });
+        }
+
+    private:
+        std::mutex mutex;
+        std::condition_variable cv;
+        const std::ptrdiff_t expected_count;
+        std::ptrdiff_t remaining;
+        std::size_t generation = 0;
+    };
+
+    // Bulk synchronous 3-point stencil: every phase reads one buffer, writes the other and waits for
+    // all the workers on the barrier before the buffers swap roles.
+    template <typename Barrier>
+    static std::vector<double> stencil(const thread_placement placement, const std::size_t workers, const int phases,
+                                       const std::size_t cells)
+    {
+        std::vector<double> current(cells, 0.0);
+        std::vector<double> next(cells, 0.0);
+        current.front() = next.front() = 1000.0; // hot boundary, it is never written
+
+        // C++20 std::latch
+        // A single use countdown. Here it is a start gate, so all the workers start the first phase together.
+        std::latch start_gate(1);
+        Barrier sync(static_cast<std::ptrdiff_t>(workers));
+        std::atomic<std::size_t> finished = 0;
+        {
+            std::vector<std::jthread> threads;
+            for (std::size_t w = 0; w < workers; ++w)
+            {
+                threads.emplace_back(placed(placement, w, [&, w]
+                {
+                    const auto begin = std::max<std::size_t>(1, cells * w / workers);
+                    const auto end = std::min(cells - 1, cells * (w + 1) / workers);
+                    double* src = current.data();
+                    double* dst = next.data();
+
+                    start_gate.wait();
+                    for (int phase = 0; phase < phases; ++phase)
+                    {
+                        {
+                            trace_zone zone("stencil phase");
+                            for (auto i = begin; i < end; ++i)
+                            {
+                                dst[i] = (src[i - 1] + src[i] + src[i + 1]) / 3.0;
+                            }
+                        }
+                        trace_zone zone("barrier wait");
+                        sync.arrive_and_wait();
+                        std::swap(src, dst);
+                    }
+                    finished.fetch_add(1);
+                    finished.notify_one();
+                }));
+            }
+            start_gate.count_down();
+
+            // C++20 std::atomic::wait
+            // Parks the thread until the value is no longer the one given, without spinning or a condvar.
+            for (auto done = finished.load(); done != workers; done = finished.load())
+            {
+                finished.wait(done);
+            }
+        }
+        return phases % 2 == 0 ? current : next;
+    }
+
+    // Empty phases, so the time per phase is the synchronization cost alone. The clock starts once every thread
+    // is waiting at the start gate and stops when the last one is done, thread creation and joins are left out.
+    template <typename Barrier>
+    static std::chrono::nanoseconds sync_cost_per_phase(const thread_placement placement, const std::size_t workers,
+                                                        const int phases)
+    {
+        Barrier sync(static_cast<std::ptrdiff_t>(workers));
+        std::latch ready(static_cast<std::ptrdiff_t>(workers));
+        std::latch start_gate(1);
+        std::latch done(static_cast<std::ptrdiff_t>(workers));
+        std::chrono::nanoseconds elapsed{};
+        {
+            std::vector<std::jthread> threads;
+            for (std::size_t w = 0; w < workers; ++w)
+            {
+                threads.emplace_back(placed(placement, w, [&]
+                {
+                    ready.count_down();
+                    start_gate.wait();
+                    for (int phase = 0; phase < phases; ++phase) sync.arrive_and_wait();
+                    done.count_down();
+                }));
+            }
+            ready.wait();
+            elapsed = measure([&]
+            {
+                start_gate.count_down();
+                done.wait();
+            });
+        }
+        return elapsed / phases;
+    }
+
+    void synchronization_primitives() const
+    {
+        print_title(__func__);
+
+        // C++20 std::barrier
+        // A reusable rendezvous point for a fixed number of threads. Each arrive_and_wait() completes a phase and
+        // the barrier resets itself for the next one. An optional completion function runs once per phase.
+        const auto hardware_threads = std::max(1u, std::thread::hardware_concurrency());
+        {
+            constexpr int phases = 200;
+            constexpr std::size_t cells = 1 << 18;
+            const auto with_barrier = stencil<std::barrier<>>(placement, hardware_threads, phases, cells);
+            const auto with_condvar = stencil<condvar_barrier>(placement, hardware_threads, phases, cells);
+            std::cout << "stencil workers=" << hardware_threads << " phases=" << phases
+                      << " cell[1]=" << with_barrier[1] << " same result with condvar barrier="
+                      << std::boolalpha << (with_barrier == with_condvar) << '\n';
+        }
+
+        // Per phase synchronization cost as the number of threads grows, in powers of two and at last with all the
+        // hardware threads.
+        for (std::size_t workers = 1; ; workers = std::min<std::size_t>(workers * 2, hardware_threads))
+        {
+            constexpr int phases = 10'000;
+            std::cout << "workers=" << workers
+                      << " std::barrier=" << sync_cost_per_phase<std::barrier<>>(placement, workers, phases).count() << "ns/phase"
+                      << " condvar barrier=" << sync_cost_per_phase<condvar_barrier>(placement, workers, phases).count() << "ns/phase\n";
+            if (workers == hardware_threads)
+            {
+                break;
+            }
+        }
+
+        // C++20 std::counting_semaphore
+        // Limits how many threads can be inside a section at the same time.
+        std::counting_semaphore<2> slots(2);
+        std::atomic<int> inside = 0;
+        std::atomic<int> max_inside = 0;
+        {
+            std::vector<std::jthread> threads;
+            for (int i = 0; i < 6; ++i)
+            {
+                threads.emplace_back(placed(placement, static_cast<std::size_t>(i), [&]
+                {
+                    slots.acquire();
+                    const int now = ++inside;
+                    int seen = max_inside.load();
+                    while (seen < now && !max_inside.compare_exchange_weak(seen, now)) { }
+                    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+                    --inside;
+                    slots.release();
+                }));
+            }
+        }
+        std::cout << "counting_semaphore<2> max threads inside=" << max_inside << '\n';
+    }
+
+    // The build times the compiler front end on each table twice, built by the compiler and built at startup (see
+    // CMakeLists.txt). The difference is what constant evaluation costs, when it is smaller than the spread between
+    // the fastest and the slowest run it is noise.
+    static void print_compile_time_cost(const std::string_view table)
+    {
+        std::cout << ", " << table << " compile time ";
+#if __has_include("CompileTimeTableCosts.h")
+        for (const auto& cost : compile_time_table_costs)
+        {
+            if (cost.table != table) continue;
+            double constant[2] = {};
+            double runtime[2] = {};
+            std::ifstream constant_file(cost.constant);
+            std::ifstream runtime_file(cost.runtime);
+            if (!(constant_file >> constant[0] >> constant[1]) || !(runtime_file >> runtime[0] >> runtime[1])) break;
+            const auto difference = constant[0] - runtime[0];
+            const auto spread = std::max(constant[1] - constant[0], runtime[1] - runtime[0]);
+            std::cout << "constant=" << std::lround(constant[0]) << "ms runtime=" << std::lround(runtime[0])
+                      << "ms cost=" << std::lround(difference) << "ms";
+            if (std::abs(difference) < spread) std::cout << " (within the " << std::lround(spread) << "ms spread)";
+            return;
+        }
+#endif
+        std::cout << "not measured, build with the project CMakeLists.txt";
+    }
+
+    void compile_time_tables() const
+    {
+        print_title(__func__);
+
+        // The compile time tables are data in the executable, they cost nothing at startup. Their price is paid by
+        // the compiler instead, see print_compile_time_cost().
+        static constexpr auto crc_table = make_crc32_table(0xEDB88320u);
+        static constexpr auto sorted = sorted_keywords();
+        static constexpr auto perfect = perfect_keyword_table();
+        static_assert(std::ranges::is_sorted(sorted));
+        static_assert(crc_table[1] == 0x77073096u);
+
+        // the polynomial goes through a volatile, otherwise the optimizer could fold the "runtime" table too
+        volatile std::uint32_t polynomial = 0xEDB88320u;
+        std::array<std::uint32_t, 256> runtime_crc_table{};
+        const auto crc_init = measure([&] { runtime_crc_table = make_crc32_table(polynomial); });
+
+        std::vector<std::uint8_t> data(1 << 24);
+        std::ranges::generate(data, [i = 0u]() mutable { return static_cast<std::uint8_t>(i++ * 2654435761u >> 24); });
+        std::uint32_t crc[2] = {};
+        const auto gbps = [&](const std::chrono::nanoseconds elapsed) { return static_cast<double>(data.size()) / elapsed.count(); };
+        const auto crc_compile_time = measure([&] { crc[0] = crc32(crc_table, data); });
+        const auto crc_runtime = measure([&] { crc[1] = crc32(runtime_crc_table, data); });
+        std::cout << "crc32 table: runtime init=" << crc_init.count() << "ns, crc32 of 16MB compile time table="
+                  << gbps(crc_compile_time) << "GB/s runtime table=" << gbps(crc_runtime) << "GB/s same crc="
+                  << std::boolalpha << (crc[0] == crc[1]);
+        print_compile_time_cost("crc32");
+        std::cout << '\n';
+
+        // Keyword recognition, the tables built at compile time against the ones a program builds at startup.
+        std::unordered_set<std::string_view> keyword_set;
+        std::vector<std::string_view> runtime_sorted;
+        const auto set_init = measure([&] { keyword_set.insert(keywords.begin(), keywords.end()); });
+        const auto sort_init = measure([&]
+        {
+            runtime_sorted.assign(keywords.begin(), keywords.end());
+            std::ranges::sort(runtime_sorted);
+        });
+
+        std::vector<std::string_view> words;
+        for (int i = 0; i < 1'000'000; ++i)
+        {
+            static constexpr std::string_view identifiers[] = {"value", "count", "index", "result", "name", "size"};
+            words.push_back(i % 2 ? keywords[i % keywords.size()] : identifiers[i % std::size(identifiers)]);
+        }
+        std::size_t found[3] = {};
+        const auto per_word = [&](const std::chrono::nanoseconds elapsed) { return static_cast<double>(elapsed.count()) / words.size(); };
+        const auto perfect_time = measure([&]
+        {
+            for (const auto word : words) found[0] += perfect.slots[keyword_slot(word, perfect.seed)] == word;
+        });
+        const auto sorted_time = measure([&] { for (const auto word : words) found[1] += std::ranges::binary_search(sorted, word); });
+        const auto set_time = measure([&] { for (const auto word : words) found[2] += keyword_set.contains(word); });
+        std::cout << "keywords: runtime init unordered_set=" << set_init.count() << "ns sorted vector="
+                  << sort_init.count() << "ns, lookup perfect hash (seed " << perfect.seed << ")=" << per_word(perfect_time)
+                  << "ns binary search=" << per_word(sorted_time) << "ns unordered_set=" << per_word(set_time)
+                  << "ns same result=" << (found[0] == found[1] && found[1] == found[2]);
+        print_compile_time_cost("sorted_keywords");
+        print_compile_time_cost("perfect_hash");
+        std::cout << '\n';
+
+#if defined(__cpp_lib_constexpr_vector)
+        static constexpr auto primes = prime_table();
+        volatile int limit = prime_limit;
+        std::vector<int> runtime_primes;
+        const auto primes_init = measure([&] { runtime_primes = primes_below(limit); });
+        std::cout << "primes below " << prime_limit << ": " << primes.size() << " in a std::array built with a constexpr "
+                  << "std::vector, runtime init=" << primes_init.count() << "ns same primes="
+                  << std::ranges::equal(primes, runtime_primes);
+        print_compile_time_cost("primes");
+        std::cout << '\n';
+#else
+        std::cout << "constexpr std::vector is not available with this toolchain\n";
+#endif
+    }
 };
 
 #endif //CPP20FEATURES_H
@@ -6,15 +6,552 @@
 
 #ifndef CPP23FEATURES_H
 #define CPP23FEATURES_H
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <expected>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <random>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+#include <vector>
 #include "CppFeatures.h"
+#include "ErrorModels.h"
+#include "ThreadPlacement.h"
+#include "ThreadPool.h"
+#include "Utilities.h"
+#if __has_include(<mdspan>)
+#include <mdspan>
+#endif
+#if __has_include(<elf.h>)
+#include <elf.h>
+#endif
+#if __has_include("ErrorModelBinaries.h")
+#include "ErrorModelBinaries.h"
+#endif
 
 class Cpp23Features final : public CppFeatures
 {
 public:
-    Cpp23Features() : CppFeatures("C++23") { }
+    explicit Cpp23Features(const thread_placement aPlacement = thread_placement::os_default)
+        : CppFeatures("C++23"), placement(aPlacement) { }
     void show_features() override
     {
-        std::cout << "Not yet implemented" << std::endl;
+        std_expected();
+        error_handling_cost();
+        formatting_throughput();
+        std_mdspan_layouts();
+    }
+
+private:
+    thread_placement placement;
+
+    void std_expected() const
+    {
+        print_title(__func__);
+
+        // C++23 std::expected
+        // Holds either a value or the error that explains why there is no value. Unlike std::optional the caller
+        // knows what went wrong, and unlike an exception the error is part of the function signature.
+        for (const std::string_view text : {"42", "", "forty two", "42abc", "99999999999"})
+        {
+            if (const auto result = parse_expected(text))
+            {
+                std::cout << "'" << text << "' value=" << *result << '\n';
+            }
+            else
+            {
+                std::cout << "'" << text << "' error=" << to_string(result.error()) << '\n';
+            }
+        }
+
+#if __cpp_lib_expected >= 202211L
+        // C++23 monadic operations, the error skips every step until somebody looks at it.
+        const auto doubled = parse_expected("21").transform([](const int v) { return v * 2; });
+        const auto failed = parse_expected("x21").transform([](const int v) { return v * 2; });
+        std::cout << "transform doubled=" << doubled.value_or(-1) << " failed=" << failed.value_or(-1) << '\n';
+#endif
+    }
+
+    // Sums the values of the inputs that parse and counts the ones that do not. The failure rate decides how often
+    // the error path runs, which is where the error models differ.
+    void error_handling_cost() const
+    {
+        print_title(__func__);
+
+        constexpr std::size_t inputs_count = 100'000;
+        std::mt19937 generator(7);
+        const std::vector<std::string> bad_inputs = {"", "abc", "12x", "99999999999"};
+
+        for (const double failure_rate : {0.0, 0.01, 0.1, 0.25, 0.5})
+        {
+            std::bernoulli_distribution fails(failure_rate);
+            std::vector<std::string> inputs;
+            inputs.reserve(inputs_count);
+            for (std::size_t i = 0; i < inputs_count; ++i)
+            {
+                inputs.push_back(fails(generator) ? bad_inputs[i % bad_inputs.size()] : std::to_string(i));
+            }
+
+            long long sum[4] = {};
+            int failures[4] = {};
+            // Best of a few runs after a warm up one, in ns per input. Each run starts its sum and failures again.
+            auto best_of = [&](const int model, auto&& run)
+            {
+                auto once = [&] { sum[model] = 0; failures[model] = 0; run(sum[model], failures[model]); };
+                once();
+                auto best = std::chrono::nanoseconds::max();
+                for (int i = 0; i < 5; ++i) best = std::min(best, measure(once));
+                return best.count() / static_cast<double>(inputs_count);
+            };
+            const double elapsed[4] = {
+                best_of(0, [&](long long& total, int& failed)
+                {
+                    for (const auto& input : inputs)
+                    {
+                        try { total += parse_or_throw(input); }
+                        catch (const std::invalid_argument&) { ++failed; }
+                    }
+                }),
+                best_of(1, [&](long long& total, int& failed)
+                {
+                    for (const auto& input : inputs)
+                    {
+                        if (const auto value = parse_expected(input)) total += *value;
+                        else ++failed;
+                    }
+                }),
+                best_of(2, [&](long long& total, int& failed)
+                {
+                    for (const auto& input : inputs)
+                    {
+                        if (const auto value = parse_optional(input)) total += *value;
+                        else ++failed;
+                    }
+                }),
+                best_of(3, [&](long long& total, int& failed)
+                {
+                    for (const auto& input : inputs)
+                    {
+                        int value = 0;
+                        if (parse_error_code(input, value) == std::errc{}) total += value;
+                        else ++failed;
+                    }
+                })
+            };
+
+            const bool agree = sum[0] == sum[1] && sum[1] == sum[2] && sum[2] == sum[3] &&
+                               failures[0] == failures[1] && failures[1] == failures[2] && failures[2] == failures[3];
+            std::cout << "failure rate=" << failure_rate * 100 << "%"
+                      << " exceptions=" << elapsed[0] << "ns"
+                      << " std::expected=" << elapsed[1] << "ns"
+                      << " std::optional=" << elapsed[2] << "ns"
+                      << " error codes=" << elapsed[3] << "ns"
+                      << " per input, failures=" << failures[0]
+                      << " all agree=" << (agree ? "true" : "false") << '\n';
+        }
+
+        // What the other models pay is a bigger return value.
+        std::cout << "sizeof int=" << sizeof(int)
+                  << " std::expected<int, parse_error>=" << sizeof(std::expected<int, parse_error>)
+                  << " std::optional<int>=" << sizeof(std::optional<int>) << '\n';
+
+        // The exception model pays in binary size even at 0% failures: unwind tables (.eh_frame) and landing pads
+        // (.gcc_except_table). The build makes one stripped error_model_* program per model, the others also without
+        // exceptions. The file sizes are padded to pages, so the loaded sections are compared instead.
+#if __has_include("ErrorModelBinaries.h")
+        for (const auto& [model, path] : error_model_binaries)
+        {
+            std::cout << "binary size " << model << ":";
+#if __has_include(<elf.h>)
+            if (const auto sizes = elf_section_sizes(path))
+            {
+                std::size_t total = 0;
+                for (std::size_t i = 0; i < std::size(size_sections); ++i)
+                {
+                    std::cout << " " << size_sections[i] << "=" << (*sizes)[i];
+                    total += (*sizes)[i];
+                }
+                std::cout << " total=" << total << " bytes\n";
+                continue;
+            }
+#endif
+            std::error_code error;
+            const auto bytes = std::filesystem::file_size(path, error);
+            if (error) std::cout << " not found\n";
+            else std::cout << " file=" << bytes << " bytes (sections not available for this format)\n";
+        }
+#else
+        std::cout << "binary sizes of the error models are reported when built with the project CMakeLists.txt\n";
+#endif
+    }
+
+    static constexpr std::string_view size_sections[] = {".text", ".rodata", ".eh_frame", ".gcc_except_table"};
+
+#if __has_include(<elf.h>)
+    // Sizes of size_sections in a 64 bit ELF file, read from its section headers. A missing section counts as 0.
+    static std::optional<std::vector<std::size_t>> elf_section_sizes(const char* path)
+    {
+        std::ifstream file(path, std::ios::binary);
+        Elf64_Ehdr header{};
+        if (!file.read(reinterpret_cast<char*>(&header), sizeof header) ||
+            std::memcmp(header.e_ident, ELFMAG, SELFMAG) != 0 || header.e_ident[EI_CLASS] != ELFCLASS64 ||
+            header.e_shentsize != sizeof(Elf64_Shdr) || header.e_shstrndx >= header.e_shnum)
+        {
+            return std::nullopt;
+        }
+        std::vector<Elf64_Shdr> sections(header.e_shnum);
+        file.seekg(static_cast<std::streamoff>(header.e_shoff));
+        file.read(reinterpret_cast<char*>(sections.data()), static_cast<std::streamsize>(sections.size() * sizeof(Elf64_Shdr)));
+        const auto& names = sections[header.e_shstrndx];
+        std::string name_table(names.sh_size, '\0');
+        file.seekg(static_cast<std::streamoff>(names.sh_offset));
+        file.read(name_table.data(), static_cast<std::streamsize>(name_table.size()));
+        if (!file)
+        {
+            return std::nullopt;
+        }
+
+        std::vector<std::size_t> sizes(std::size(size_sections));
+        for (const auto& section : sections)
+        {
+            if (section.sh_name >= name_table.size()) continue;
+            const std::string_view name = name_table.c_str() + section.sh_name;
+            for (std::size_t i = 0; i < sizes.size(); ++i)
+            {
+                if (name == size_sections[i]) sizes[i] += section.sh_size;
+            }
+        }
+        return sizes;
+    }
+#endif
+
+    // Formats every value with each method and reports the time per value. The output is not identical, the default
+    // floating point format of printf/iostreams has 6 digits while std::format uses the shortest exact form.
+    template <typename T>
+    static void formatting_cost(const std::string_view type, const std::vector<T>& values)
+    {
+        std::size_t characters = 0;
+        auto per_value = [&](auto&& format_one)
+        {
+            characters = 0;
+            const auto elapsed = measure([&] { for (const auto& value : values) characters += format_one(value); });
+            do_not_optimize(characters);
+            return elapsed.count() / static_cast<long long>(values.size());
+        };
+
+        // iostreams, with the stream reused so only the formatting is measured
+        std::ostringstream os;
+        const auto with_iostreams = per_value([&](const T& value) { os.str({}); os << value; return os.view().size(); });
+
+        // printf family, into a stack buffer
+        char buffer[64];
+        const auto with_printf = per_value([&](const T& value)
+        {
+            if constexpr (std::is_integral_v<T>) return std::snprintf(buffer, sizeof buffer, "%d", value);
+            else if constexpr (std::is_floating_point_v<T>) return std::snprintf(buffer, sizeof buffer, "%g", value);
+            else return std::snprintf(buffer, sizeof buffer, "%s", value.c_str());
+        });
+
+        std::cout << type << ": iostreams=" << with_iostreams << "ns printf=" << with_printf << "ns";
+#if defined(__cpp_lib_format)
+        // C++20 std::format, returns a new std::string every time
+        const auto with_format = per_value([](const T& value) { return std::format("{}", value).size(); });
+
+        // C++20 std::format_to_n, writes into a stack buffer and never more than its size
+        const auto with_format_to_n = per_value([&](const T& value)
+        {
+            return std::format_to_n(buffer, sizeof buffer, "{}", value).size;
+        });
+        std::cout << " std::format=" << with_format << "ns std::format_to_n=" << with_format_to_n << "ns";
+#endif
+        std::cout << " per value\n";
+    }
+
+    void formatting_throughput() const
+    {
+        print_title(__func__);
+
+#if !defined(__cpp_lib_format)
+        std::cout << "std::format is not available with this toolchain, only iostreams and printf are measured\n";
+#endif
+        constexpr std::size_t count = 200'000;
+        std::mt19937 generator(11);
+        std::vector<int> integers(count);
+        std::vector<double> floats(count);
+        std::vector<std::string> strings(count);
+        std::uniform_int_distribution<int> any_int(-1'000'000'000, 1'000'000'000);
+        std::uniform_real_distribution<double> any_double(-1e6, 1e6);
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            integers[i] = any_int(generator);
+            floats[i] = any_double(generator);
+            strings[i] = "request-" + std::to_string(i);
+        }
+
+        formatting_cost("integers", integers);
+        formatting_cost("floats", floats);
+        formatting_cost("strings", strings);
+    }
+
+    // m[i, j] needs the multidimensional subscript operator of the compiler as well as std::mdspan in the library.
+#if defined(__cpp_lib_mdspan) && defined(__cpp_multidimensional_subscript)
+    // A custom mdspan layout: the matrix is stored as tile x tile blocks, each block contiguous and in row-major
+    // order, blocks in row-major order too. Two elements that are close in any direction are likely in the same
+    // block, and a block of doubles (8 KB for 32 x 32) fits in the L1 cache.
+    template <std::size_t tile>
+    struct layout_tiled
+    {
+        template <typename Extents>
+        class mapping
+        {
+        public:
+            static_assert(Extents::rank() == 2, "layout_tiled is for matrices");
+            using extents_type = Extents;
+            using index_type = typename Extents::index_type;
+            using size_type = typename Extents::size_type;
+            using rank_type = typename Extents::rank_type;
+            using layout_type = layout_tiled;
+
+            constexpr mapping() noexcept = default;
+            constexpr explicit mapping(const extents_type& aExtents) noexcept
+                : matrix_extents(aExtents), tiles_per_row(tiles(aExtents.extent(1))) { }
+
+            [[nodiscard]] constexpr const extents_type& extents() const noexcept { return matrix_extents; }
+
+            [[nodiscard]] constexpr index_type required_span_size() const noexcept
+            {
+                return tiles(matrix_extents.extent(0)) * tiles_per_row * tile * tile;
+            }
+
+            constexpr index_type operator()(const index_type row, const index_type column) const noexcept
+            {
+                const auto block = (row / tile) * tiles_per_row + column / tile;
+                return block * tile * tile + (row % tile) * tile + column % tile;
+            }
+
+            // Every element has its own offset, but partial blocks leave holes and no single stride describes a
+            // dimension.
+            static constexpr bool is_always_unique() noexcept { return true; }
+            static constexpr bool is_always_exhaustive() noexcept { return false; }
+            static constexpr bool is_always_strided() noexcept { return false; }
+            static constexpr bool is_unique() noexcept { return true; }
+            [[nodiscard]] constexpr bool is_exhaustive() const noexcept
+            {
+                return matrix_extents.extent(0) % tile == 0 && matrix_extents.extent(1) % tile == 0;
+            }
+            static constexpr bool is_strided() noexcept { return false; }
+
+            friend constexpr bool operator==(const mapping& a, const mapping& b) noexcept
+            {
+                return a.extents() == b.extents();
+            }
+
+        private:
+            static constexpr index_type tiles(const index_type elements) { return (elements + tile - 1) / tile; }
+
+            extents_type matrix_extents{};
+            index_type tiles_per_row = 0; // computed once, the offset of every access needs it
+        };
+    };
+
+    static constexpr std::size_t tile = 32;
+    using matrix_extents = std::dextents<std::size_t, 2>;
+
+    // Owns the storage of a square matrix and views it with the given layout.
+    template <typename Layout>
+    struct matrix
+    {
+        explicit matrix(const std::size_t n)
+            : mapping(matrix_extents(n, n)), storage(mapping.required_span_size()), view(storage.data(), mapping) { }
+
+        typename Layout::template mapping<matrix_extents> mapping;
+        std::vector<double> storage;
+        std::mdspan<double, matrix_extents, Layout> view;
+    };
+
+    // The same loops run over every layout, only the mdspan type changes.
+    template <typename In, typename Out>
+    static void transpose(const In& in, const Out& out, const std::size_t first_row, const std::size_t last_row)
+    {
+        for (std::size_t i = first_row; i < last_row; ++i)
+            for (std::size_t j = 0; j < in.extent(1); ++j)
+                out[j, i] = in[i, j];
+    }
+
+    // Tile by tile, so the rows read and the columns written stay in cache. The rows given must be multiples of the
+    // tile, as the matrix size.
+    template <typename In, typename Out>
+    static void transpose_blocked(const In& in, const Out& out, const std::size_t first_row, const std::size_t last_row)
+    {
+        for (std::size_t ii = first_row; ii < last_row; ii += tile)
+            for (std::size_t jj = 0; jj < in.extent(1); jj += tile)
+                for (std::size_t i = ii; i < ii + tile; ++i)
+                    for (std::size_t j = jj; j < jj + tile; ++j)
+                        out[j, i] = in[i, j];
+    }
+
+    template <typename A, typename B, typename C>
+    static void multiply(const A& a, const B& b, const C& c, const std::size_t first_row, const std::size_t last_row)
+    {
+        for (std::size_t i = first_row; i < last_row; ++i)
+            for (std::size_t j = 0; j < c.extent(1); ++j)
+            {
+                double sum = 0;
+                for (std::size_t k = 0; k < a.extent(1); ++k) sum += a[i, k] * b[k, j];
+                c[i, j] = sum;
+            }
+    }
+
+    // Cache blocking: works on tile x tile blocks so the three blocks in use stay in cache. Same constraint on the
+    // rows as transpose_blocked(). The tile wide piece of a row is contiguous in row-major and tiled layouts, so the
+    // inner loop runs over plain pointers the compiler can vectorize.
+    template <typename A, typename B, typename C>
+    static void multiply_blocked(const A& a, const B& b, const C& c, const std::size_t first_row, const std::size_t last_row)
+    {
+        const auto n = a.extent(1);
+        for (std::size_t ii = first_row; ii < last_row; ii += tile)
+            for (std::size_t jj = 0; jj < n; jj += tile)
+            {
+                for (std::size_t i = ii; i < ii + tile; ++i)
+                    for (std::size_t j = jj; j < jj + tile; ++j)
+                        c[i, j] = 0;
+                for (std::size_t kk = 0; kk < n; kk += tile)
+                    for (std::size_t i = ii; i < ii + tile; ++i)
+                    {
+                        double* c_row = &c[i, jj];
+                        for (std::size_t k = kk; k < kk + tile; ++k)
+                        {
+                            const auto aik = a[i, k];
+                            const double* b_row = &b[k, jj];
+                            for (std::size_t j = 0; j < tile; ++j) c_row[j] += aik * b_row[j];
+                        }
+                    }
+            }
+    }
+
+    template <typename Left, typename Right>
+    static bool same_values(const Left& left, const Right& right)
+    {
+        for (std::size_t i = 0; i < left.extent(0); ++i)
+            for (std::size_t j = 0; j < left.extent(1); ++j)
+                if (std::abs(left[i, j] - right[i, j]) > 1e-9 * std::max(1.0, std::abs(left[i, j]))) return false;
+        return true;
+    }
+#endif
+
+    void std_mdspan_layouts() const
+    {
+        print_title(__func__);
+
+#if defined(__cpp_lib_mdspan) && defined(__cpp_multidimensional_subscript)
+        // C++23 std::mdspan
+        // A non owning multidimensional view: a pointer, the extents and a layout mapping that turns indexes into an
+        // offset. std::layout_right is row-major, std::layout_left column-major, and any type that follows the
+        // layout mapping requirements can be plugged in, like layout_tiled above.
+        // C++23 multidimensional subscript, m[i, j] instead of m[i][j] or m(i, j).
+        thread_pool pool(std::max(1u, std::thread::hardware_concurrency()), placement);
+        std::mt19937 generator(9);
+        std::uniform_real_distribution<double> any(-1.0, 1.0);
+
+        auto fill = [&](const auto& m)
+        {
+            for (std::size_t i = 0; i < m.extent(0); ++i)
+                for (std::size_t j = 0; j < m.extent(1); ++j)
+                    m[i, j] = any(generator);
+        };
+        auto copy = [](const auto& from, const auto& to)
+        {
+            for (std::size_t i = 0; i < from.extent(0); ++i)
+                for (std::size_t j = 0; j < from.extent(1); ++j)
+                    to[i, j] = from[i, j];
+        };
+
+        {
+            constexpr std::size_t n = 2048;
+            const auto gbps = [](const std::chrono::nanoseconds elapsed)
+            {
+                return 2.0 * n * n * sizeof(double) / static_cast<double>(elapsed.count());
+            };
+            matrix<std::layout_right> in_rows(n);
+            matrix<std::layout_right> out_rows(n);
+            matrix<std::layout_left> out_columns(n);
+            matrix<layout_tiled<tile>> in_tiles(n);
+            matrix<layout_tiled<tile>> out_tiles(n);
+            fill(in_rows.view);
+            copy(in_rows.view, in_tiles.view);
+
+            // row-major to row-major writes a column for every row read, row-major to column-major reads and
+            // writes sequentially (the layout itself is the transpose).
+            const auto rows_to_rows = measure([&] { transpose(in_rows.view, out_rows.view, 0, n); });
+            const auto rows_to_columns = measure([&] { transpose(in_rows.view, out_columns.view, 0, n); });
+            const auto rows_blocked = measure([&] { transpose_blocked(in_rows.view, out_rows.view, 0, n); });
+            const auto tiles_to_tiles = measure([&] { transpose_blocked(in_tiles.view, out_tiles.view, 0, n); });
+            const auto parallel_tiles = measure([&]
+            {
+                pool.parallel_for(0, n, tile, [&](const std::size_t first, const std::size_t last)
+                {
+                    transpose_blocked(in_tiles.view, out_tiles.view, first, last);
+                });
+            });
+            std::cout << "transpose " << n << "x" << n << ": row-major->row-major=" << gbps(rows_to_rows)
+                      << " row-major->column-major=" << gbps(rows_to_columns)
+                      << " row-major->row-major blocked=" << gbps(rows_blocked) << " tiled->tiled blocked=" << gbps(tiles_to_tiles)
+                      << " tiled->tiled " << pool.size() << " threads=" << gbps(parallel_tiles)
+                      << " GB/s, same result=" << std::boolalpha << (same_values(out_rows.view, out_columns.view) &&
+                                                                     same_values(out_rows.view, out_tiles.view)) << '\n';
+        }
+        {
+            constexpr std::size_t n = 512;
+            const auto gflops = [](const std::chrono::nanoseconds elapsed)
+            {
+                return 2.0 * n * n * n / static_cast<double>(elapsed.count());
+            };
+            matrix<std::layout_right> a(n);
+            matrix<std::layout_right> b_rows(n);
+            matrix<std::layout_left> b_columns(n);
+            matrix<layout_tiled<tile>> a_tiles(n);
+            matrix<layout_tiled<tile>> b_tiles(n);
+            matrix<std::layout_right> c_naive(n);
+            matrix<std::layout_right> c_columns(n);
+            matrix<std::layout_right> c_blocked(n);
+            matrix<layout_tiled<tile>> c_tiles(n);
+            matrix<layout_tiled<tile>> c_parallel(n);
+            fill(a.view);
+            fill(b_rows.view);
+            copy(b_rows.view, b_columns.view);
+            copy(a.view, a_tiles.view);
+            copy(b_rows.view, b_tiles.view);
+
+            // the inner loop walks a row of A and a column of B, B's layout decides if that column is contiguous
+            const auto naive = measure([&] { multiply(a.view, b_rows.view, c_naive.view, 0, n); });
+            const auto b_column_major = measure([&] { multiply(a.view, b_columns.view, c_columns.view, 0, n); });
+            const auto rows_blocked = measure([&] { multiply_blocked(a.view, b_rows.view, c_blocked.view, 0, n); });
+            const auto tiled_blocked = measure([&] { multiply_blocked(a_tiles.view, b_tiles.view, c_tiles.view, 0, n); });
+            const auto parallel = measure([&]
+            {
+                pool.parallel_for(0, n, tile, [&](const std::size_t first, const std::size_t last)
+                {
+                    multiply_blocked(a_tiles.view, b_tiles.view, c_parallel.view, first, last);
+                });
+            });
+            std::cout << "multiply " << n << "x" << n << ": naive row-major=" << gflops(naive) << " (" << to_ms(naive)
+                      << "ms) B column-major=" << gflops(b_column_major) << " row-major blocked=" << gflops(rows_blocked) << " tiled and blocked=" << gflops(tiled_blocked)
+                      << " tiled and blocked " << pool.size() << " threads=" << gflops(parallel)
+                      << " GFLOP/s, same result=" << std::boolalpha
+                      << (same_values(c_naive.view, c_columns.view) && same_values(c_naive.view, c_blocked.view) &&
+                          same_values(c_naive.view, c_tiles.view) &&
+                          same_values(c_naive.view, c_parallel.view)) << '\n';
+        }
+#else
+        std::cout << "std::mdspan or the multidimensional subscript operator is not available with this toolchain\n";
+#endif
     }
 };
 
@@ -6,7 +6,33 @@
 
 #ifndef CPP26FEATURES_H
 #define CPP26FEATURES_H
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <vector>
 #include "CppFeatures.h"
+#include "Utilities.h"
+#if __has_include(<experimental/simd>)
+#include <experimental/simd>
+#endif
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define CPP26_SSE2_INTRINSICS 1
+#endif
+
+// Keeps the compiler from vectorizing the scalar reference kernels.
+#if defined(__clang__)
+#define SCALAR_FUNCTION
+#define SCALAR_LOOP _Pragma("clang loop vectorize(disable) interleave(disable)")
+#elif defined(__GNUC__)
+#define SCALAR_FUNCTION __attribute__((optimize("no-tree-vectorize")))
+#define SCALAR_LOOP
+#else
+#define SCALAR_FUNCTION
+#define SCALAR_LOOP
+#endif
 
 class Cpp26Features final : public CppFeatures
 {
@@ -14,7 +40,326 @@ public:
     Cpp26Features() : CppFeatures("C++26") { }
     void show_features() override
     {
-        std::cout << "Not yet implemented. Probably it is a little too soon for that.\n";
+        data_parallel_types();
+    }
+
+private:
+#if defined(__cpp_lib_experimental_parallel_simd)
+    // std::simd (C++26) comes from the Parallelism TS 2, libstdc++ ships the TS version in <experimental/simd>.
+    // native_simd<T> is a pack of as many T as fit the widest registers the target was compiled for.
+    using simd_int = std::experimental::native_simd<int>;
+    using simd_float = std::experimental::native_simd<float>;
+    using simd_byte = std::experimental::native_simd<std::uint8_t>;
+    static constexpr auto element_aligned = std::experimental::element_aligned;
+#endif
+
+    // Every kernel comes in four flavours: a scalar loop the compiler is told not to vectorize, the same loop left
+    // to the autovectorizer, std::experimental::simd, and SSE2 intrinsics. The autovectorizer cannot reorder the
+    // float additions of the dot product (no -ffast-math) nor vectorize the early exit of the byte search, so those
+    // two stay scalar unless written by hand.
+
+    SCALAR_FUNCTION static long long sum_scalar(const std::vector<int>& v)
+    {
+        long long sum = 0;
+        SCALAR_LOOP for (const int x : v) sum += x;
+        return sum;
+    }
+    static long long sum_auto(const std::vector<int>& v)
+    {
+        int sum = 0; // same lane type as the vector versions, the inputs are small enough not to overflow
+        for (const int x : v) sum += x;
+        return sum;
+    }
+
+    SCALAR_FUNCTION static long long min_max_scalar(const std::vector<int>& v)
+    {
+        int low = v.front();
+        int high = v.front();
+        SCALAR_LOOP for (const int x : v) { low = std::min(low, x); high = std::max(high, x); }
+        return static_cast<long long>(high) * 1000 + low;
+    }
+    static long long min_max_auto(const std::vector<int>& v)
+    {
+        int low = v.front();
+        int high = v.front();
+        for (const int x : v) { low = std::min(low, x); high = std::max(high, x); }
+        return static_cast<long long>(high) * 1000 + low;
+    }
+
+    SCALAR_FUNCTION static double dot_scalar(const std::vector<float>& a, const std::vector<float>& b)
+    {
+        float sum = 0;
+        SCALAR_LOOP for (std::size_t i = 0; i < a.size(); ++i) sum += a[i] * b[i];
+        return sum;
+    }
+    static double dot_auto(const std::vector<float>& a, const std::vector<float>& b)
+    {
+        float sum = 0;
+        for (std::size_t i = 0; i < a.size(); ++i) sum += a[i] * b[i];
+        return sum;
+    }
+
+    SCALAR_FUNCTION static long long find_scalar(const std::vector<std::uint8_t>& v, const std::uint8_t needle)
+    {
+        SCALAR_LOOP for (std::size_t i = 0; i < v.size(); ++i) if (v[i] == needle) return static_cast<long long>(i);
+        return -1;
+    }
+    static long long find_auto(const std::vector<std::uint8_t>& v, const std::uint8_t needle)
+    {
+        const auto it = std::find(v.begin(), v.end(), needle);
+        return it == v.end() ? -1 : it - v.begin();
+    }
+
+    SCALAR_FUNCTION static long long clamp_scalar(const std::vector<int>& v, std::vector<int>& out)
+    {
+        SCALAR_LOOP for (std::size_t i = 0; i < v.size(); ++i) out[i] = std::clamp(v[i], 50, 200);
+        return out[v.size() / 2];
+    }
+    static long long clamp_auto(const std::vector<int>& v, std::vector<int>& out)
+    {
+        for (std::size_t i = 0; i < v.size(); ++i) out[i] = std::clamp(v[i], 50, 200);
+        return out[v.size() / 2];
+    }
+
+#if defined(__cpp_lib_experimental_parallel_simd)
+    // The loops step one simd pack at a time, the leftover elements go through the scalar tail.
+    static long long sum_simd(const std::vector<int>& v)
+    {
+        simd_int sum = 0;
+        std::size_t i = 0;
+        for (; i + simd_int::size() <= v.size(); i += simd_int::size())
+        {
+            sum += simd_int(&v[i], element_aligned);
+        }
+        int total = std::experimental::reduce(sum);
+        for (; i < v.size(); ++i) total += v[i];
+        return total;
+    }
+
+    static long long min_max_simd(const std::vector<int>& v)
+    {
+        simd_int low = v.front();
+        simd_int high = v.front();
+        std::size_t i = 0;
+        for (; i + simd_int::size() <= v.size(); i += simd_int::size())
+        {
+            const simd_int x(&v[i], element_aligned);
+            low = std::experimental::min(low, x);
+            high = std::experimental::max(high, x);
+        }
+        int lowest = std::experimental::hmin(low);
+        int highest = std::experimental::hmax(high);
+        for (; i < v.size(); ++i) { lowest = std::min(lowest, v[i]); highest = std::max(highest, v[i]); }
+        return static_cast<long long>(highest) * 1000 + lowest;
+    }
+
+    static double dot_simd(const std::vector<float>& a, const std::vector<float>& b)
+    {
+        simd_float sum = 0;
+        std::size_t i = 0;
+        for (; i + simd_float::size() <= a.size(); i += simd_float::size())
+        {
+            sum += simd_float(&a[i], element_aligned) * simd_float(&b[i], element_aligned);
+        }
+        float total = std::experimental::reduce(sum);
+        for (; i < a.size(); ++i) total += a[i] * b[i];
+        return total;
+    }
+
+    static long long find_simd(const std::vector<std::uint8_t>& v, const std::uint8_t needle)
+    {
+        std::size_t i = 0;
+        for (; i + simd_byte::size() <= v.size(); i += simd_byte::size())
+        {
+            if (const auto found = simd_byte(&v[i], element_aligned) == needle; std::experimental::any_of(found))
+            {
+                return static_cast<long long>(i) + std::experimental::find_first_set(found);
+            }
+        }
+        for (; i < v.size(); ++i) if (v[i] == needle) return static_cast<long long>(i);
+        return -1;
+    }
+
+    static long long clamp_simd(const std::vector<int>& v, std::vector<int>& out)
+    {
+        const simd_int low = 50;
+        const simd_int high = 200;
+        std::size_t i = 0;
+        for (; i + simd_int::size() <= v.size(); i += simd_int::size())
+        {
+            std::experimental::clamp(simd_int(&v[i], element_aligned), low, high).copy_to(&out[i], element_aligned);
+        }
+        for (; i < v.size(); ++i) out[i] = std::clamp(v[i], 50, 200);
+        return out[v.size() / 2];
+    }
+#endif
+
+#if defined(CPP26_SSE2_INTRINSICS)
+    // SSE2 is the x86-64 baseline. It has no 32 bit min/max (SSE4.1), so they are a compare and a select.
+    static __m128i select(const __m128i mask, const __m128i a, const __m128i b)
+    {
+        return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+    }
+    static __m128i load(const void* p) { return _mm_loadu_si128(static_cast<const __m128i*>(p)); }
+
+    static long long sum_sse2(const std::vector<int>& v)
+    {
+        __m128i sum = _mm_setzero_si128();
+        std::size_t i = 0;
+        for (; i + 4 <= v.size(); i += 4) sum = _mm_add_epi32(sum, load(&v[i]));
+        alignas(16) int lanes[4];
+        _mm_store_si128(reinterpret_cast<__m128i*>(lanes), sum);
+        int total = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+        for (; i < v.size(); ++i) total += v[i];
+        return total;
+    }
+
+    static long long min_max_sse2(const std::vector<int>& v)
+    {
+        __m128i low = _mm_set1_epi32(v.front());
+        __m128i high = low;
+        std::size_t i = 0;
+        for (; i + 4 <= v.size(); i += 4)
+        {
+            const auto x = load(&v[i]);
+            low = select(_mm_cmplt_epi32(x, low), x, low);
+            high = select(_mm_cmpgt_epi32(x, high), x, high);
+        }
+        alignas(16) int lows[4];
+        alignas(16) int highs[4];
+        _mm_store_si128(reinterpret_cast<__m128i*>(lows), low);
+        _mm_store_si128(reinterpret_cast<__m128i*>(highs), high);
+        int lowest = *std::min_element(lows, lows + 4);
+        int highest = *std::max_element(highs, highs + 4);
+        for (; i < v.size(); ++i) { lowest = std::min(lowest, v[i]); highest = std::max(highest, v[i]); }
+        return static_cast<long long>(highest) * 1000 + lowest;
+    }
+
+    static double dot_sse2(const std::vector<float>& a, const std::vector<float>& b)
+    {
+        __m128 sum = _mm_setzero_ps();
+        std::size_t i = 0;
+        for (; i + 4 <= a.size(); i += 4) sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(&a[i]), _mm_loadu_ps(&b[i])));
+        alignas(16) float lanes[4];
+        _mm_store_ps(lanes, sum);
+        float total = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+        for (; i < a.size(); ++i) total += a[i] * b[i];
+        return total;
+    }
+
+    static long long find_sse2(const std::vector<std::uint8_t>& v, const std::uint8_t needle)
+    {
+        const auto pattern = _mm_set1_epi8(static_cast<char>(needle));
+        std::size_t i = 0;
+        for (; i + 16 <= v.size(); i += 16)
+        {
+            if (const int found = _mm_movemask_epi8(_mm_cmpeq_epi8(load(&v[i]), pattern)); found != 0)
+            {
+                return static_cast<long long>(i) + std::countr_zero(static_cast<unsigned>(found));
+            }
+        }
+        for (; i < v.size(); ++i) if (v[i] == needle) return static_cast<long long>(i);
+        return -1;
+    }
+
+    static long long clamp_sse2(const std::vector<int>& v, std::vector<int>& out)
+    {
+        const auto low = _mm_set1_epi32(50);
+        const auto high = _mm_set1_epi32(200);
+        std::size_t i = 0;
+        for (; i + 4 <= v.size(); i += 4)
+        {
+            auto x = load(&v[i]);
+            x = select(_mm_cmplt_epi32(x, low), low, x);
+            x = select(_mm_cmpgt_epi32(x, high), high, x);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(&out[i]), x);
+        }
+        for (; i < v.size(); ++i) out[i] = std::clamp(v[i], 50, 200);
+        return out[v.size() / 2];
+    }
+#endif
+
+    // Best of a few runs, as GB/s of input read. Results are compared against the scalar version.
+    template <typename Kernel>
+    static double throughput(const std::size_t bytes, const double expected, Kernel&& kernel, bool& agrees)
+    {
+        auto best = std::chrono::nanoseconds::max();
+        for (int run = 0; run < 5; ++run)
+        {
+            double result = 0;
+            best = std::min(best, measure([&] { result = static_cast<double>(kernel()); }));
+            agrees = agrees && std::abs(result - expected) <= 1e-3 * std::abs(expected);
+        }
+        return static_cast<double>(bytes) / static_cast<double>(best.count());
+    }
+
+    template <typename Scalar, typename Auto, typename Simd, typename Intrinsics>
+    static void report(const char* kernel, const std::size_t bytes, Scalar&& scalar, Auto&& autovectorized,
+                       [[maybe_unused]] Simd&& simd, [[maybe_unused]] Intrinsics&& intrinsics)
+    {
+        const auto expected = static_cast<double>(scalar());
+        bool agrees = true;
+        std::cout << kernel << ": scalar=" << throughput(bytes, expected, scalar, agrees)
+                  << " autovectorized=" << throughput(bytes, expected, autovectorized, agrees);
+#if defined(__cpp_lib_experimental_parallel_simd)
+        std::cout << " simd=" << throughput(bytes, expected, simd, agrees);
+#endif
+#if defined(CPP26_SSE2_INTRINSICS)
+        std::cout << " sse2=" << throughput(bytes, expected, intrinsics, agrees);
+#endif
+        std::cout << " GB/s, results agree=" << std::boolalpha << agrees << '\n';
+    }
+
+    void data_parallel_types() const
+    {
+        print_title(__func__);
+
+#if defined(__cpp_lib_experimental_parallel_simd)
+        std::cout << "native_simd<int> has " << simd_int::size() << " lanes, native_simd<uint8_t> has "
+                  << simd_byte::size() << " lanes\n";
+#else
+        std::cout << "std::experimental::simd is not available with this toolchain, it is left out\n";
+#endif
+
+        constexpr std::size_t count = 1 << 22;
+        std::mt19937 generator(5);
+        std::uniform_int_distribution<int> small(0, 255);
+        std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+        std::vector<int> ints(count);
+        std::vector<int> clamped(count);
+        std::vector<float> a(count);
+        std::vector<float> b(count);
+        std::vector<std::uint8_t> bytes(count * 4, 0);
+        std::ranges::generate(ints, [&] { return small(generator); });
+        std::ranges::generate(a, [&] { return unit(generator); });
+        std::ranges::generate(b, [&] { return unit(generator); });
+        bytes[bytes.size() - 100] = 0xFF; // the needle, near the end
+
+        // When a flavour is not compiled in its lambda is simply never called.
+        [[maybe_unused]] auto none = [] { return 0; };
+        const auto int_bytes = count * sizeof(int);
+#if defined(__cpp_lib_experimental_parallel_simd)
+#define SIMD_KERNEL(call) [&] { return call; }
+#else
+#define SIMD_KERNEL(call) none
+#endif
+#if defined(CPP26_SSE2_INTRINSICS)
+#define SSE2_KERNEL(call) [&] { return call; }
+#else
+#define SSE2_KERNEL(call) none
+#endif
+        report("sum", int_bytes, [&] { return sum_scalar(ints); }, [&] { return sum_auto(ints); },
+               SIMD_KERNEL(sum_simd(ints)), SSE2_KERNEL(sum_sse2(ints)));
+        report("min/max", int_bytes, [&] { return min_max_scalar(ints); }, [&] { return min_max_auto(ints); },
+               SIMD_KERNEL(min_max_simd(ints)), SSE2_KERNEL(min_max_sse2(ints)));
+        report("dot product", 2 * count * sizeof(float), [&] { return dot_scalar(a, b); }, [&] { return dot_auto(a, b); },
+               SIMD_KERNEL(dot_simd(a, b)), SSE2_KERNEL(dot_sse2(a, b)));
+        report("byte search", bytes.size(), [&] { return find_scalar(bytes, 0xFF); }, [&] { return find_auto(bytes, 0xFF); },
+               SIMD_KERNEL(find_simd(bytes, 0xFF)), SSE2_KERNEL(find_sse2(bytes, 0xFF)));
+        report("clamp", int_bytes, [&] { return clamp_scalar(ints, clamped); }, [&] { return clamp_auto(ints, clamped); },
+               SIMD_KERNEL(clamp_simd(ints, clamped)), SSE2_KERNEL(clamp_sse2(ints, clamped)));
+#undef SIMD_KERNEL
+#undef SSE2_KERNEL
     }
 };
 
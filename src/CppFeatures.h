@@ -6,22 +6,65 @@
 #ifndef CPPFEATURES_H
 #define CPPFEATURES_H
 
+#include <cstdio>
 #include <iostream>
+#include <iterator>
 #include <string>
+#include <string_view>
+#include <utility>
+#include <version>
+#if defined(__cpp_lib_format)
+#include <format>
+#endif
+
+#if defined(__cpp_lib_format)
+// C++20 std::format_to
+// Formats into a buffer that is reused by every call on the thread and writes it to stdout at once, the same as
+// std::print but without allocating a new string each time. stdout is shared with std::cout, so both can be mixed.
+template <typename... Args>
+void emit(std::format_string<Args...> format, Args&&... args)
+{
+    thread_local std::string output;
+    output.clear();
+    std::format_to(std::back_inserter(output), format, std::forward<Args>(args)...);
+    std::fwrite(output.data(), 1, output.size(), stdout);
+}
+#else
+// Fallback without std::format: each "{}" is replaced by the next argument written with operator<< to std::cout.
+// Format specifications and "{{" escapes are not supported.
+template <typename... Args>
+void emit(const std::string_view format, Args&&... args)
+{
+    std::size_t position = 0;
+    auto field = [&](auto&& arg)
+    {
+        const auto next = format.find("{}", position);
+        if (next == std::string_view::npos)
+        {
+            return;
+        }
+        std::cout << format.substr(position, next - position) << arg;
+        position = next + 2;
+    };
+    (field(std::forward<Args>(args)), ...);
+    std::cout << format.substr(position);
+}
+#endif
 
 class CppFeatures {
 public:
-    explicit CppFeatures(const std::string& versionString)
+    explicit CppFeatures(const std::string_view versionString)
     {
-        std::cout << "----- " << versionString << " -----" << std::endl;
+        emit("----- {} -----\n", versionString);
+        std::fflush(stdout);
     }
     virtual ~CppFeatures() = default;
     virtual void show_features() = 0;
 
 protected:
-    void print_title(const std::string& title) const
+    void print_title(const std::string_view title) const
     {
-        std::cout << "* " << title << " example *\n";
+        emit("* {} example *\n", title);
     }
 };
 
@@ -0,0 +1,85 @@
+// (c) 2025 Patricio Palma (ppalma.dev AT protonmail.com)
+//
+// The same fallible parser with four error models: exceptions, std::expected, std::optional and error codes. All of
+// them agree on what is an error. Used by Cpp23Features and by the error_model_* programs that measure the binary
+// size of each model.
+
+#ifndef ERRORMODELS_H
+#define ERRORMODELS_H
+
+#include <charconv>
+#include <expected>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+
+enum class parse_error { empty, not_a_number, out_of_range, trailing_characters };
+
+inline std::string_view to_string(const parse_error error)
+{
+    switch (error)
+    {
+    case parse_error::empty: return "empty";
+    case parse_error::not_a_number: return "not a number";
+    case parse_error::out_of_range: return "out of range";
+    default: return "trailing characters";
+    }
+}
+
+inline std::optional<parse_error> classify(const std::string_view text, int& value)
+{
+    if (text.empty())
+    {
+        return parse_error::empty;
+    }
+    const auto [end, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+    if (ec == std::errc::invalid_argument) return parse_error::not_a_number;
+    if (ec == std::errc::result_out_of_range) return parse_error::out_of_range;
+    if (end != text.data() + text.size()) return parse_error::trailing_characters;
+    return std::nullopt;
+}
+
+#if defined(__cpp_exceptions)
+inline int parse_or_throw(const std::string_view text)
+{
+    int value = 0;
+    if (const auto error = classify(text, value))
+    {
+        throw std::invalid_argument(std::string(to_string(*error)));
+    }
+    return value;
+}
+#endif
+
+inline std::expected<int, parse_error> parse_expected(const std::string_view text)
+{
+    int value = 0;
+    if (const auto error = classify(text, value))
+    {
+        return std::unexpected(*error);
+    }
+    return value;
+}
+
+inline std::optional<int> parse_optional(const std::string_view text)
+{
+    int value = 0;
+    if (const auto error = classify(text, value))
+    {
+        return std::nullopt;
+    }
+    return value;
+}
+
+inline std::errc parse_error_code(const std::string_view text, int& value)
+{
+    if (classify(text, value))
+    {
+        return std::errc::invalid_argument;
+    }
+    return {};
+}
+
+#endif //ERRORMODELS_H
@@ -0,0 +1,244 @@
+// (c) 2025 Patricio Palma (ppalma.dev AT protonmail.com)
+//
+// Open addressing hash map in the style of the "Swiss tables". Keys and values live in one flat array of slots and
+// every slot has a control byte: empty, deleted, or 7 bits of the hash of its key. Lookups compare 16 control bytes
+// at a time (with SSE2 when available) and only touch the slots whose control byte matches.
+
+#ifndef FLATHASHMAP_H
+#define FLATHASHMAP_H
+
+#include <algorithm>
+#include <bit>
+#include <concepts>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string_view>
+#include <utility>
+#include <vector>
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define FLAT_HASH_MAP_SSE2 1
+#endif
+
+// Transparent string hash, so a map with std::string keys can be searched with a std::string_view or a literal
+// without building a std::string first.
+struct string_hash
+{
+    using is_transparent = void;
+    std::size_t operator()(const std::string_view text) const { return std::hash<std::string_view>{}(text); }
+};
+
+// Keys a map can be searched with: its own key type, or anything when both the hash and the equality are transparent.
+template <typename K, typename Key, typename Hash, typename KeyEqual>
+concept lookup_key_for = std::same_as<K, Key> ||
+    requires { typename Hash::is_transparent; typename KeyEqual::is_transparent; };
+
+template <typename Key, typename Value, typename Hash = std::hash<Key>, typename KeyEqual = std::equal_to<Key>>
+class flat_hash_map
+{
+public:
+    using slot_type = std::pair<Key, Value>;
+
+    flat_hash_map() = default;
+    flat_hash_map(const flat_hash_map&) = delete;
+    flat_hash_map& operator=(const flat_hash_map&) = delete;
+    ~flat_hash_map() { destroy(); }
+
+    [[nodiscard]] std::size_t size() const { return count; }
+    [[nodiscard]] std::size_t capacity() const { return control.size(); }
+    // Bytes allocated by the table: the slots plus one control byte each.
+    [[nodiscard]] std::size_t memory_bytes() const { return capacity() * (sizeof(slot_type) + 1); }
+
+    template <typename K>
+        requires lookup_key_for<K, Key, Hash, KeyEqual>
+    [[nodiscard]] Value* find(const K& key)
+    {
+        const auto index = find_index(key);
+        return index == npos ? nullptr : &slots[index].second;
+    }
+
+    template <typename K>
+        requires lookup_key_for<K, Key, Hash, KeyEqual>
+    [[nodiscard]] bool contains(const K& key) const { return find_index(key) != npos; }
+
+    // Returns false, and leaves the map untouched, when the key is already there.
+    bool emplace(Key key, Value value)
+    {
+        if (find_index(key) != npos)
+        {
+            return false;
+        }
+        // deleted slots count as used, otherwise a probe could run without ever finding an empty slot
+        if ((count + deleted + 1) * 8 > capacity() * 7)
+        {
+            // mostly deleted slots: clean them up at the same capacity, otherwise grow
+            const bool mostly_deleted = (count + 1) * 16 <= capacity() * 7;
+            rehash(mostly_deleted ? capacity() : std::max(group_size, capacity() * 2));
+        }
+        insert_unique(std::move(key), std::move(value));
+        return true;
+    }
+
+    template <typename K>
+        requires lookup_key_for<K, Key, Hash, KeyEqual>
+    bool erase(const K& key)
+    {
+        const auto index = find_index(key);
+        if (index == npos)
+        {
+            return false;
+        }
+        std::destroy_at(&slots[index]);
+        control[index] = deleted_slot;
+        --count;
+        ++deleted;
+        return true;
+    }
+
+private:
+    static constexpr std::size_t group_size = 16;
+    static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+    static constexpr std::size_t next_group = npos - 1;
+    static constexpr std::int8_t empty_slot = -128;   // 0b10000000
+    static constexpr std::int8_t deleted_slot = -2;   // 0b11111110, full slots are 0b0xxxxxxx
+
+    // Spreads the bits of the user hash (std::hash<int> is the identity) and splits it: the low 7 bits go to the
+    // control byte, the rest selects the first group to probe.
+    static std::uint64_t mix(std::uint64_t hash)
+    {
+        hash *= 0x9E3779B97F4A7C15ull;
+        return hash ^ (hash >> 32);
+    }
+
+    // Bit i is set when control byte i of the group matches.
+    static std::uint32_t match(const std::int8_t* group, const std::int8_t byte)
+    {
+#if defined(FLAT_HASH_MAP_SSE2)
+        const auto bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(group));
+        return static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, _mm_set1_epi8(byte))));
+#else
+        std::uint32_t mask = 0;
+        for (std::size_t i = 0; i < group_size; ++i)
+        {
+            mask |= static_cast<std::uint32_t>(group[i] == byte) << i;
+        }
+        return mask;
+#endif
+    }
+
+    // Empty and deleted are the only control bytes with the high bit set.
+    static std::uint32_t match_free(const std::int8_t* group)
+    {
+#if defined(FLAT_HASH_MAP_SSE2)
+        return static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(group))));
+#else
+        std::uint32_t mask = 0;
+        for (std::size_t i = 0; i < group_size; ++i)
+        {
+            mask |= static_cast<std::uint32_t>(group[i] < 0) << i;
+        }
+        return mask;
+#endif
+    }
+
+    // Groups are visited at triangular offsets, with a power of two group count this visits every group once.
+    template <typename Visit>
+    std::size_t probe(const std::uint64_t hash, Visit&& visit) const
+    {
+        const auto group_mask = capacity() / group_size - 1;
+        auto group = (hash >> 7) & group_mask;
+        for (std::size_t step = 1; ; ++step)
+        {
+            if (const auto index = visit(group * group_size); index != next_group)
+            {
+                return index;
+            }
+            group = (group + step) & group_mask;
+        }
+    }
+
+    template <typename K>
+    std::size_t find_index(const K& key) const
+    {
+        if (count == 0)
+        {
+            return npos;
+        }
+        const auto hash = mix(Hash{}(key));
+        const auto h2 = static_cast<std::int8_t>(hash & 0x7F);
+        // visit returns the slot found, npos to stop the search, or next_group to keep probing
+        return probe(hash, [&](const std::size_t first) -> std::size_t
+        {
+            for (auto candidates = match(&control[first], h2); candidates != 0; candidates &= candidates - 1)
+            {
+                const auto index = first + static_cast<std::size_t>(std::countr_zero(candidates));
+                if (KeyEqual{}(slots[index].first, key))
+                {
+                    return index;
+                }
+            }
+            return match(&control[first], empty_slot) != 0 ? npos : next_group;
+        });
+    }
+
+    void insert_unique(Key&& key, Value&& value)
+    {
+        const auto hash = mix(Hash{}(key));
+        const auto index = probe(hash, [&](const std::size_t first) -> std::size_t
+        {
+            const auto free = match_free(&control[first]);
+            return free != 0 ? first + static_cast<std::size_t>(std::countr_zero(free)) : next_group;
+        });
+        if (control[index] == deleted_slot)
+        {
+            --deleted;
+        }
+        control[index] = static_cast<std::int8_t>(hash & 0x7F);
+        std::construct_at(&slots[index], std::move(key), std::move(value));
+        ++count;
+    }
+
+    // Moves every element into a new table, which also drops the deleted slots.
+    void rehash(const std::size_t new_capacity)
+    {
+        auto old_control = std::exchange(control, std::vector<std::int8_t>(new_capacity, empty_slot));
+        auto old_slots = std::exchange(slots, std::allocator<slot_type>{}.allocate(new_capacity));
+        count = 0;
+        deleted = 0;
+        for (std::size_t i = 0; i < old_control.size(); ++i)
+        {
+            if (old_control[i] >= 0)
+            {
+                insert_unique(std::move(old_slots[i].first), std::move(old_slots[i].second));
+                std::destroy_at(&old_slots[i]);
+            }
+        }
+        if (old_slots)
+        {
+            std::allocator<slot_type>{}.deallocate(old_slots, old_control.size());
+        }
+    }
+
+    void destroy()
+    {
+        for (std::size_t i = 0; i < control.size(); ++i)
+        {
+            if (control[i] >= 0)
+            {
+                std::destroy_at(&slots[i]);
+            }
+        }
+        if (slots)
+        {
+            std::allocator<slot_type>{}.deallocate(slots, control.size());
+        }
+    }
+
+    std::vector<std::int8_t> control;   // one byte per slot, capacity is a power of two multiple of group_size
+    slot_type* slots = nullptr;         // uninitialized storage, only slots with a full control byte hold an element
+    std::size_t count = 0;
+    std::size_t deleted = 0;
+};
+
+#endif //FLATHASHMAP_H
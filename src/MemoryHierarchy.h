@@ -0,0 +1,311 @@
+// (c) 2025 Patricio Palma (ppalma.dev AT protonmail.com)
+//
+// Memory hierarchy probe. The same loop runs at very different speeds depending on whether its data fits in L1,
+// L2, the last level cache or only in DRAM. This section measures latency and bandwidth for working sets from 4 KB
+// up, finds the plateaus and writes everything to memory_hierarchy.json, the baseline to read the other results
+// against on each machine.
+
+#ifndef MEMORYHIERARCHY_H
+#define MEMORYHIERARCHY_H
+
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+#include "CppFeatures.h"
+#include "ThreadPlacement.h"
+#include "ThreadPool.h"
+#include "Utilities.h"
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#endif
+
+class MemoryHierarchy final : public CppFeatures
+{
+public:
+    explicit MemoryHierarchy(const thread_placement aPlacement = thread_placement::os_default)
+        : CppFeatures("Memory hierarchy"), placement(aPlacement) { }
+
+    void show_features() override
+    {
+        latency_and_bandwidth_sweep();
+    }
+
+private:
+    thread_placement placement;
+
+    // One cache line. Pointer chasing follows next through a random cycle, every load depends on the previous one
+    // so the time per load is the latency of wherever the line lives.
+    struct alignas(64) line
+    {
+        line* next;
+    };
+
+    struct sample
+    {
+        std::size_t bytes = 0;
+        double latency_ns = 0;
+        double read_gbps = 0;
+        double write_gbps = 0;
+        double strided_read_gbps = 0;   // one 8 byte load per cache line, counted as the whole line moved
+        double read_gbps_all_threads = 0;
+    };
+
+    struct plateau
+    {
+        std::string level;
+        std::size_t from_bytes = 0;
+        std::size_t up_to_bytes = 0;
+        double latency_ns = 0;
+        double read_gbps = 0;
+        std::size_t reported_bytes = 0;     // the size the OS reports for this level, 0 when it reports none
+    };
+
+    struct reported_cache
+    {
+        int level = 0;
+        std::string type;
+        std::size_t bytes = 0;
+    };
+
+    // Largest working set: 1 GB, or less on machines with little memory (two buffers of that size are used).
+    static std::size_t max_working_set()
+    {
+        std::size_t limit = std::size_t{1} << 30;
+#if defined(_SC_PHYS_PAGES) && defined(_SC_PAGESIZE)
+        const auto physical = static_cast<std::size_t>(sysconf(_SC_PHYS_PAGES)) * static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+        while (limit > (std::size_t{1} << 20) && limit * 8 > physical) limit /= 2;
+#endif
+        return limit;
+    }
+
+    static double chase_latency(std::vector<line>& lines, const std::size_t count, std::mt19937_64& generator)
+    {
+        // Sattolo's algorithm, a random permutation that is a single cycle through all the lines
+        std::vector<std::size_t> next(count);
+        std::iota(next.begin(), next.end(), 0);
+        for (std::size_t i = count - 1; i > 0; --i)
+        {
+            std::swap(next[i], next[std::uniform_int_distribution<std::size_t>(0, i - 1)(generator)]);
+        }
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            lines[i].next = &lines[next[i]];
+        }
+
+        constexpr std::size_t loads = 1 << 20;
+        const line* p = &lines[0];
+        for (std::size_t i = 0; i < std::min(count, loads); ++i) p = p->next; // warm up
+        const auto elapsed = measure([&] { for (std::size_t i = 0; i < loads; ++i) p = p->next; });
+        do_not_optimize(p);
+        return static_cast<double>(elapsed.count()) / loads;
+    }
+
+    // Moves at least 64 MB per measurement, smaller working sets are repeated.
+    static std::size_t repeats(const std::size_t bytes) { return std::max<std::size_t>(1, (std::size_t{64} << 20) / bytes); }
+
+    static std::uint64_t read(const std::uint64_t* data, const std::size_t words, const std::size_t stride)
+    {
+        std::uint64_t sum = 0;
+        for (std::size_t i = 0; i < words; i += stride) sum += data[i];
+        return sum;
+    }
+
+    static double gbps(const std::size_t bytes, const std::chrono::nanoseconds elapsed)
+    {
+        return static_cast<double>(bytes) / static_cast<double>(std::max<long long>(1, elapsed.count()));
+    }
+
+    // Caches the OS reports, to compare with the detected plateaus.
+    static std::vector<reported_cache> reported_caches()
+    {
+        std::vector<reported_cache> caches;
+#if defined(__linux__)
+        std::error_code error;
+        for (const auto& entry : std::filesystem::directory_iterator("/sys/devices/system/cpu/cpu0/cache", error))
+        {
+            reported_cache cache;
+            std::string size;
+            std::ifstream(entry.path() / "level") >> cache.level;
+            std::ifstream(entry.path() / "type") >> cache.type;
+            std::ifstream(entry.path() / "size") >> size; // "48K", "2048K", "32M"
+            if (cache.level == 0 || size.empty())
+            {
+                continue;
+            }
+            cache.bytes = std::stoull(size) * (size.back() == 'M' ? 1 << 20 : size.back() == 'K' ? 1 << 10 : 1);
+            caches.push_back(cache);
+        }
+        std::ranges::sort(caches, {}, &reported_cache::level);
+#endif
+        return caches;
+    }
+
+    // The largest working sets are DRAM: every size from the end whose latency is at least a third of the latency of
+    // the largest one, the rise inside DRAM is TLB misses, not another level. Below it a cache plateau is a run of
+    // sizes whose latency stays within 25% of the first size of the run, single sizes between runs are transitions
+    // and are left out. The cache plateaus are named in the order of their latencies, L1, L2 and, from the third
+    // one, the last is the LLC. The OS reported cache sizes are only attached as a cross-check.
+    static std::vector<plateau> find_plateaus(const std::vector<sample>& samples, const std::vector<reported_cache>& caches)
+    {
+        if (samples.empty())
+        {
+            return {};
+        }
+        auto dram = samples.end() - 1;
+        while (dram != samples.begin() && (dram - 1)->latency_ns * 3 >= samples.back().latency_ns) --dram;
+
+        std::vector<std::vector<sample>> runs;
+        for (auto s = samples.begin(); s != dram; ++s)
+        {
+            if (runs.empty() || s->latency_ns > runs.back().front().latency_ns * 1.25)
+            {
+                runs.emplace_back();
+            }
+            runs.back().push_back(*s);
+        }
+        std::erase_if(runs, [](const auto& run) { return run.size() < 2; });
+
+        const auto reported = [&](const int level)
+        {
+            const auto cache = std::ranges::find_if(caches, [&](const reported_cache& c)
+            {
+                return c.level == level && c.type != "Instruction";
+            });
+            return cache == caches.end() ? std::size_t{0} : cache->bytes;
+        };
+        const auto at_middle = [](auto first, auto last, plateau p)
+        {
+            const auto& middle = *(first + (last - first) / 2);
+            p.from_bytes = first->bytes;
+            p.up_to_bytes = (last - 1)->bytes;
+            p.latency_ns = middle.latency_ns;
+            p.read_gbps = middle.read_gbps;
+            return p;
+        };
+
+        std::vector<plateau> plateaus;
+        for (std::size_t r = 0; r < runs.size(); ++r)
+        {
+            const auto level = static_cast<int>(r + 1);
+            const bool last_cache = r >= 2 && r + 1 == runs.size();
+            plateau p{last_cache ? std::string("LLC") : std::string("L").append(std::to_string(level))};
+            p.reported_bytes = reported(last_cache && !caches.empty() ? caches.back().level : level);
+            plateaus.push_back(at_middle(runs[r].begin(), runs[r].end(), p));
+        }
+        plateaus.push_back(at_middle(dram, samples.end(), plateau{"DRAM"}));
+        return plateaus;
+    }
+
+    static void write_json(const std::string& path, const std::vector<sample>& samples,
+                           const std::vector<plateau>& plateaus, const std::vector<reported_cache>& caches)
+    {
+        std::ofstream out(path);
+        out << "{\n  \"sizes\": [";
+        for (std::size_t i = 0; i < samples.size(); ++i)
+        {
+            const auto& s = samples[i];
+            out << (i ? "," : "") << "\n    {\"bytes\": " << s.bytes << ", \"latency_ns\": " << s.latency_ns
+                << ", \"read_gbps\": " << s.read_gbps << ", \"write_gbps\": " << s.write_gbps
+                << ", \"strided_read_gbps\": " << s.strided_read_gbps
+                << ", \"read_gbps_all_threads\": " << s.read_gbps_all_threads << "}";
+        }
+        out << "\n  ],\n  \"plateaus\": [";
+        for (std::size_t i = 0; i < plateaus.size(); ++i)
+        {
+            const auto& p = plateaus[i];
+            out << (i ? "," : "") << "\n    {\"level\": \"" << p.level << "\", \"from_bytes\": " << p.from_bytes
+                << ", \"up_to_bytes\": " << p.up_to_bytes << ", \"latency_ns\": " << p.latency_ns
+                << ", \"read_gbps\": " << p.read_gbps << ", \"reported_bytes\": " << p.reported_bytes << "}";
+        }
+        out << "\n  ],\n  \"reported_caches\": [";
+        for (std::size_t i = 0; i < caches.size(); ++i)
+        {
+            const auto& c = caches[i];
+            out << (i ? "," : "") << "\n    {\"level\": " << c.level << ", \"type\": \"" << c.type
+                << "\", \"bytes\": " << c.bytes << "}";
+        }
+        out << "\n  ]\n}\n";
+    }
+
+    void latency_and_bandwidth_sweep() const
+    {
+        print_title(__func__);
+
+        const auto max_bytes = max_working_set();
+        std::vector<line> lines(max_bytes / sizeof(line));
+        std::vector<std::uint64_t> words(max_bytes / sizeof(std::uint64_t), 1);
+        std::mt19937_64 generator(1);
+
+        // Every thread of the pool reads its own buffer of the working set size, that is the aggregated bandwidth of
+        // the private caches first and of the shared ones and DRAM later.
+        thread_pool pool(std::max(1u, std::thread::hardware_concurrency()), placement);
+        const auto per_thread_limit = max_bytes / pool.size();
+
+        std::vector<sample> samples;
+        for (std::size_t bytes = 4096; bytes <= max_bytes; bytes *= 2)
+        {
+            sample s{bytes};
+            const auto count = bytes / sizeof(std::uint64_t);
+            const auto times = repeats(bytes);
+            std::uint64_t sum = 0;
+
+            s.latency_ns = chase_latency(lines, bytes / sizeof(line), generator);
+            sum += read(words.data(), count, 1); // warm up
+            s.read_gbps = gbps(bytes * times, measure([&] { for (std::size_t r = 0; r < times; ++r) sum += read(words.data(), count, 1); }));
+            s.write_gbps = gbps(bytes * times, measure([&]
+            {
+                for (std::size_t r = 0; r < times; ++r) std::fill_n(words.data(), count, r);
+                do_not_optimize(words.data()[0]);
+            }));
+            s.strided_read_gbps = gbps(bytes * times, measure([&]
+            {
+                for (std::size_t r = 0; r < times; ++r) sum += read(words.data(), count, sizeof(line) / sizeof(std::uint64_t));
+            }));
+            if (bytes <= per_thread_limit)
+            {
+                s.read_gbps_all_threads = gbps(bytes * times * pool.size(), measure([&]
+                {
+                    pool.parallel_for(0, pool.size(), 1, [&](const std::size_t first, const std::size_t last)
+                    {
+                        for (auto t = first; t < last; ++t)
+                        {
+                            const auto* data = words.data() + t * count;
+                            std::uint64_t thread_sum = 0;
+                            for (std::size_t r = 0; r < times; ++r) thread_sum += read(data, count, 1);
+                            do_not_optimize(thread_sum);
+                        }
+                    });
+                }));
+            }
+            do_not_optimize(sum);
+            samples.push_back(s);
+
+            std::cout << bytes / 1024 << "KB: latency=" << s.latency_ns << "ns read=" << s.read_gbps
+                      << " write=" << s.write_gbps << " strided read=" << s.strided_read_gbps << " read "
+                      << pool.size() << " threads=" << s.read_gbps_all_threads << " GB/s\n";
+        }
+
+        const auto caches = reported_caches();
+        const auto plateaus = find_plateaus(samples, caches);
+        for (const auto& p : plateaus)
+        {
+            std::cout << p.level << " " << p.from_bytes / 1024 << "KB to " << p.up_to_bytes / 1024 << "KB latency="
+                      << p.latency_ns << "ns read=" << p.read_gbps << "GB/s";
+            if (p.reported_bytes != 0) std::cout << " (reported " << p.reported_bytes / 1024 << "KB)";
+            std::cout << '\n';
+        }
+        for (const auto& c : caches)
+        {
+            std::cout << "reported L" << c.level << " " << c.type << " cache " << c.bytes / 1024 << "KB\n";
+        }
+        write_json("memory_hierarchy.json", samples, plateaus, caches);
+        std::cout << "written to memory_hierarchy.json\n";
+    }
+};
+
+#endif //MEMORYHIERARCHY_H
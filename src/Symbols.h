@@ -0,0 +1,167 @@
+// (c) 2025 Patricio Palma (ppalma.dev AT protonmail.com)
+//
+// Compact identifiers. A symbol is an interned string: the table stores each distinct text once, and a symbol is a
+// pointer to that copy, so comparing and hashing symbols never looks at the characters. An inline_string keeps a
+// short text inside the object itself, with no heap allocation and a fixed size.
+
+#ifndef SYMBOLS_H
+#define SYMBOLS_H
+
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+#include "FlatHashMap.h"
+
+class symbol
+{
+public:
+    symbol() = default; // the empty text
+
+    // Valid for as long as the table that interned the symbol.
+    [[nodiscard]] std::string_view view() const
+    {
+        std::uint32_t length;
+        std::memcpy(&length, text - sizeof(length), sizeof(length));
+        return {text, length};
+    }
+    operator std::string_view() const { return view(); }
+
+    // Same table, same text, same pointer.
+    bool operator==(const symbol& other) const { return text == other.text; }
+
+    friend std::ostream& operator<<(std::ostream& os, const symbol& s) { return os << s.view(); }
+
+private:
+    friend class symbol_table;
+    friend struct std::hash<symbol>;
+
+    explicit symbol(const char* aText) : text(aText) { }
+
+    // The characters follow their length, stored as an unaligned std::uint32_t.
+    static constexpr char empty_entry[sizeof(std::uint32_t) + 1] = {};
+
+    const char* text = empty_entry + sizeof(std::uint32_t);
+};
+
+template <>
+struct std::hash<symbol>
+{
+    std::size_t operator()(const symbol& s) const { return std::hash<const char*>{}(s.text); }
+};
+
+// Not thread safe, see intern() for the shared table.
+class symbol_table
+{
+public:
+    symbol_table() = default;
+    symbol_table(const symbol_table&) = delete;
+    symbol_table& operator=(const symbol_table&) = delete;
+
+    symbol intern(const std::string_view text)
+    {
+        if (text.empty())
+        {
+            return {};
+        }
+        if (const auto* found = index.find(text))
+        {
+            return *found;
+        }
+        const auto stored = store(text);
+        index.emplace(stored.view(), stored);
+        return stored;
+    }
+
+    [[nodiscard]] std::size_t size() const { return index.size(); }
+    // Bytes allocated for the texts and the index.
+    [[nodiscard]] std::size_t memory_bytes() const { return allocated + index.memory_bytes(); }
+
+private:
+    static constexpr std::size_t chunk_size = 64 * 1024;
+
+    // Texts are appended to fixed chunks that are never moved, so the views handed out stay valid. A text larger
+    // than a chunk gets a chunk of its own.
+    symbol store(const std::string_view text)
+    {
+        if (text.size() > UINT32_MAX)
+        {
+            throw std::length_error("symbol text too long");
+        }
+        const auto length = static_cast<std::uint32_t>(text.size());
+        const auto needed = sizeof(length) + text.size();
+        if (chunks.empty() || used + needed > chunk_capacity)
+        {
+            chunk_capacity = std::max(chunk_size, needed);
+            chunks.push_back(std::make_unique_for_overwrite<char[]>(chunk_capacity));
+            allocated += chunk_capacity;
+            used = 0;
+        }
+        auto* entry = chunks.back().get() + used;
+        std::memcpy(entry, &length, sizeof(length));
+        std::memcpy(entry + sizeof(length), text.data(), text.size());
+        used += needed;
+        return symbol(entry + sizeof(length));
+    }
+
+    std::vector<std::unique_ptr<char[]>> chunks;
+    std::size_t chunk_capacity = 0;
+    std::size_t used = 0;
+    std::size_t allocated = 0;
+    flat_hash_map<std::string_view, symbol> index; // the keys view the stored texts
+};
+
+// The process wide table, for names that live as long as the program. Safe to call from any thread.
+inline symbol intern(const std::string_view text)
+{
+    static std::mutex mutex;
+    static auto& table = *new symbol_table; // never destroyed, symbols stay valid until the very end
+    std::lock_guard<std::mutex> lock(mutex);
+    return table.intern(text);
+}
+
+// Up to Capacity characters stored inside the object. Longer texts throw std::length_error, like std::string does
+// past max_size().
+template <std::size_t Capacity>
+class inline_string
+{
+    static_assert(Capacity < 256, "the length is stored in one byte");
+
+public:
+    inline_string() = default;
+    explicit inline_string(const std::string_view text)
+    {
+        if (text.size() > Capacity)
+        {
+            throw std::length_error("inline_string capacity exceeded");
+        }
+        std::memcpy(chars, text.data(), text.size());
+        length = static_cast<unsigned char>(text.size());
+    }
+
+    [[nodiscard]] std::string_view view() const { return {chars, length}; }
+    operator std::string_view() const { return view(); }
+    [[nodiscard]] std::size_t size() const { return length; }
+    static constexpr std::size_t capacity() { return Capacity; }
+
+    bool operator==(const inline_string& other) const { return view() == other.view(); }
+
+    friend std::ostream& operator<<(std::ostream& os, const inline_string& s) { return os << s.view(); }
+
+private:
+    char chars[Capacity] = {};
+    unsigned char length = 0;
+};
+
+template <std::size_t Capacity>
+struct std::hash<inline_string<Capacity>>
+{
+    std::size_t operator()(const inline_string<Capacity>& s) const { return std::hash<std::string_view>{}(s.view()); }
+};
+
+#endif //SYMBOLS_H
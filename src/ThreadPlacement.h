@@ -0,0 +1,184 @@
+// (c) 2025 Patricio Palma (ppalma.dev AT protonmail.com)
+//
+// Thread placement for the threaded sections. On Linux the topology is read from /sys/devices/system/cpu and
+// threads are pinned with pthread_setaffinity_np, elsewhere every policy falls back to the OS scheduler.
+
+#ifndef THREADPLACEMENT_H
+#define THREADPLACEMENT_H
+
+#include <algorithm>
+#include <concepts>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <tuple>
+#include <utility>
+#include <vector>
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+enum class thread_placement
+{
+    os_default,     // no pinning, the OS decides
+    same_cpu,       // every thread on the same logical cpu
+    smt_siblings,   // fill the hardware threads of a core before moving to the next core
+    spread          // one thread per core, alternating sockets, SMT siblings last
+};
+
+inline std::string_view to_string(const thread_placement placement)
+{
+    switch (placement)
+    {
+    case thread_placement::same_cpu: return "same-cpu";
+    case thread_placement::smt_siblings: return "smt";
+    case thread_placement::spread: return "spread";
+    default: return "os";
+    }
+}
+
+inline thread_placement thread_placement_from_name(const std::string_view name)
+{
+    for (const auto placement : {thread_placement::same_cpu, thread_placement::smt_siblings, thread_placement::spread})
+    {
+        if (name == to_string(placement))
+        {
+            return placement;
+        }
+    }
+    if (name != to_string(thread_placement::os_default))
+    {
+        std::cout << "unknown thread placement '" << name << "', using os\n";
+    }
+    return thread_placement::os_default;
+}
+
+struct logical_cpu
+{
+    int id = 0;
+    int core = 0;
+    int package = 0;
+};
+
+// Logical cpus this process is allowed to run on, with their core and socket.
+inline std::vector<logical_cpu> cpu_topology()
+{
+    std::vector<logical_cpu> cpus;
+#if defined(__linux__)
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    sched_getaffinity(0, sizeof(allowed), &allowed);
+
+    auto read_int = [](const std::filesystem::path& path, int& value)
+    {
+        std::ifstream file(path);
+        return static_cast<bool>(file >> value);
+    };
+
+    std::error_code error;
+    for (const auto& entry : std::filesystem::directory_iterator("/sys/devices/system/cpu", error))
+    {
+        const auto name = entry.path().filename().string();
+        if (name.size() < 4 || !name.starts_with("cpu") ||
+            !std::all_of(name.begin() + 3, name.end(), [](const char c) { return c >= '0' && c <= '9'; }))
+        {
+            continue;
+        }
+        logical_cpu cpu{std::stoi(name.substr(3))};
+        // offline cpus have no topology directory
+        if (cpu.id < CPU_SETSIZE && CPU_ISSET(cpu.id, &allowed) &&
+            read_int(entry.path() / "topology" / "core_id", cpu.core) &&
+            read_int(entry.path() / "topology" / "physical_package_id", cpu.package))
+        {
+            cpus.push_back(cpu);
+        }
+    }
+#endif
+    if (cpus.empty())
+    {
+        for (int id = 0; id < static_cast<int>(std::max(1u, std::thread::hardware_concurrency())); ++id)
+        {
+            cpus.push_back({id, id, 0});
+        }
+    }
+    std::ranges::sort(cpus, {}, [](const logical_cpu& cpu) { return std::tie(cpu.package, cpu.core, cpu.id); });
+    return cpus;
+}
+
+// Order in which the policy hands out cpus to thread indexes.
+inline std::vector<logical_cpu> placement_order(const thread_placement placement)
+{
+    static const auto topology = cpu_topology();
+    if (placement != thread_placement::spread)
+    {
+        return topology; // already in package, core, smt order
+    }
+
+    // rank of each cpu inside its core and of each core inside its package
+    struct ranked { logical_cpu cpu; int smt_rank; int core_rank; };
+    std::vector<ranked> cpus;
+    std::map<std::pair<int, int>, int> cpus_per_core;
+    std::map<int, std::map<int, int>> cores_per_package;
+    for (const auto& cpu : topology)
+    {
+        auto& cores = cores_per_package[cpu.package];
+        const auto core_rank = cores.try_emplace(cpu.core, static_cast<int>(cores.size())).first->second;
+        cpus.push_back({cpu, cpus_per_core[{cpu.package, cpu.core}]++, core_rank});
+    }
+    std::ranges::sort(cpus, {}, [](const ranked& r) { return std::tie(r.smt_rank, r.core_rank, r.cpu.package); });
+
+    std::vector<logical_cpu> order;
+    for (const auto& r : cpus)
+    {
+        order.push_back(r.cpu);
+    }
+    return order;
+}
+
+// Logical cpu for the index-th thread of a policy, or -1 when the OS should decide.
+inline int cpu_for(const thread_placement placement, const std::size_t index)
+{
+    if (placement == thread_placement::os_default)
+    {
+        return -1;
+    }
+    const auto order = placement_order(placement);
+    return placement == thread_placement::same_cpu ? order.front().id : order[index % order.size()].id;
+}
+
+inline bool pin_current_thread(const int cpu)
+{
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    (void)cpu;
+    return false;
+#endif
+}
+
+// Wraps a thread payload so it pins itself before running.
+//   std::thread t(placed(placement, i, payload), args...);
+template <typename Callable>
+auto placed(const thread_placement placement, const std::size_t index, Callable&& callable)
+{
+    return [cpu = cpu_for(placement, index), callable = std::forward<Callable>(callable)]<typename... Args>(Args&&... args) mutable
+        requires std::invocable<Callable&, Args...>
+    {
+        if (cpu >= 0)
+        {
+            pin_current_thread(cpu);
+        }
+        return std::invoke(callable, std::forward<Args>(args)...);
+    };
+}
+
+#endif //THREADPLACEMENT_H
@@ -0,0 +1,118 @@
+// (c) 2025 Patricio Palma (ppalma.dev AT protonmail.com)
+//
+// A fixed set of worker threads taking tasks from a shared queue. Unless disabled, every task runs inside a trace
+// zone, so the pool shows up in the trace timeline, and the workers are placed with the given thread placement policy.
+
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#include "ThreadPlacement.h"
+#include "Tracing.h"
+
+class thread_pool
+{
+public:
+    // Without tracing the tasks pay nothing for it, for benchmarks that compare the pool with code that is not traced.
+    explicit thread_pool(const std::size_t threads = std::max(1u, std::thread::hardware_concurrency()),
+                         const thread_placement placement = thread_placement::os_default, const bool aTraced = true)
+        : traced(aTraced)
+    {
+        for (std::size_t i = 0; i < threads; ++i)
+        {
+            workers.emplace_back(placed(placement, i, [this](const std::stop_token& stop) { work(stop); }));
+        }
+    }
+
+    // The workers finish the queued tasks before they stop.
+    ~thread_pool()
+    {
+        {
+            // under the lock, or a worker between its wait predicate and the wait itself would miss the wake up
+            std::lock_guard<std::mutex> lock(mutex);
+            for (auto& worker : workers) { worker.request_stop(); }
+        }
+        ready.notify_all();
+    }
+
+    thread_pool(const thread_pool&) = delete;
+    thread_pool& operator=(const thread_pool&) = delete;
+
+    [[nodiscard]] std::size_t size() const { return workers.size(); }
+
+    // The result, or the exception, of the callable is delivered through the returned future.
+    template <typename Callable>
+    std::future<std::invoke_result_t<Callable>> submit(Callable&& callable)
+    {
+        // std::function needs a copyable target, the std::packaged_task is shared instead of moved in
+        auto task = std::make_shared<std::packaged_task<std::invoke_result_t<Callable>()>>(std::forward<Callable>(callable));
+        auto result = task->get_future();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            tasks.emplace_back([task] { (*task)(); });
+        }
+        ready.notify_one();
+        return result;
+    }
+
+    // Splits [begin, end) in chunks of at least grain indexes, runs body(first, last) for each chunk in the pool
+    // and waits for all of them.
+    template <typename Body>
+    void parallel_for(const std::size_t begin, const std::size_t end, const std::size_t grain, Body&& body)
+    {
+        const auto chunks = std::max<std::size_t>(1, std::min((end - begin) / grain, size() * 4));
+        const auto per_chunk = (end - begin + chunks - 1) / chunks;
+        const auto chunk = (per_chunk + grain - 1) / grain * grain;
+        std::vector<std::future<void>> done;
+        for (auto first = begin; first < end; first += chunk)
+        {
+            done.push_back(submit([&body, first, last = std::min(end, first + chunk)] { body(first, last); }));
+        }
+        for (auto& d : done) { d.get(); }
+    }
+
+private:
+    void work(const std::stop_token& stop)
+    {
+        while (true)
+        {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                ready.wait(lock, [&] { return !tasks.empty() || stop.stop_requested(); });
+                if (tasks.empty())
+                {
+                    return;
+                }
+                task = std::move(tasks.front());
+                tasks.pop_front();
+            }
+            if (traced)
+            {
+                trace_zone zone("pool task");
+                task();
+            }
+            else
+            {
+                task();
+            }
+        }
+    }
+
+    const bool traced;
+    std::mutex mutex;
+    std::condition_variable ready;
+    std::deque<std::function<void()>> tasks;
+    std::vector<std::jthread> workers; // last member, the threads stop and join before the queue is destroyed
+};
+
+#endif //THREADPOOL_H
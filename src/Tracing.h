@@ -0,0 +1,199 @@
+// (c) 2025 Patricio Palma (ppalma.dev AT protonmail.com)
+//
+// Timeline of the threaded sections. A trace_zone records when a scope started and ended on the current thread,
+// write_chrome_trace() saves every zone recorded so far in the Chrome trace event format, which can be opened with
+// chrome://tracing or https://ui.perfetto.dev.
+//
+// Each thread writes to its own buffer, so recording a zone takes no lock: the only shared accesses are the release
+// stores that publish the events, and new chunks, for the exporter. A buffer grows a chunk at a time up to a limit
+// of about a million zones per thread, past it zones are dropped and counted.
+
+#ifndef TRACING_H
+#define TRACING_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+#if defined(_M_X64)
+#include <intrin.h>
+#define TRACE_TSC 1
+#elif defined(__x86_64__)
+#include <x86intrin.h>
+#define TRACE_TSC 1
+#endif
+
+struct trace_event
+{
+    const char* name;           // string with static storage, __func__ or a literal
+    std::uint64_t begin;        // trace_ticks()
+    std::uint64_t end;
+};
+
+class trace_buffer
+{
+public:
+    static constexpr std::size_t chunk_capacity = 4096;
+    static constexpr std::size_t max_chunks = 256;
+
+    // A fixed block of events. The owning thread links a new one when it is full.
+    struct chunk
+    {
+        trace_event events[chunk_capacity];
+        std::atomic<std::size_t> committed = 0;
+        std::atomic<chunk*> next = nullptr;
+    };
+
+    explicit trace_buffer(const std::uint32_t aThreadId) : thread_id(aThreadId) { }
+    ~trace_buffer()
+    {
+        for (auto* c = first->next.load(std::memory_order_acquire); c != nullptr; )
+        {
+            delete std::exchange(c, c->next.load(std::memory_order_acquire));
+        }
+    }
+    trace_buffer(const trace_buffer&) = delete;
+    trace_buffer& operator=(const trace_buffer&) = delete;
+
+    // Only called by the thread that owns the buffer.
+    void record(const char* name, const std::uint64_t begin, const std::uint64_t end)
+    {
+        auto index = last->committed.load(std::memory_order_relaxed);
+        if (index == chunk_capacity)
+        {
+            if (chunks == max_chunks)
+            {
+                dropped.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+            // the chunk is complete before the exporter can reach it through next
+            auto* grown = new chunk;
+            last->next.store(grown, std::memory_order_release);
+            last = grown;
+            ++chunks;
+            index = 0;
+        }
+        last->events[index] = {name, begin, end};
+        last->committed.store(index + 1, std::memory_order_release);
+    }
+
+    // Calls visit(event) for every published event, from any thread.
+    template <typename Visit>
+    void for_each(Visit&& visit) const
+    {
+        for (const auto* c = first.get(); c != nullptr; c = c->next.load(std::memory_order_acquire))
+        {
+            const auto count = c->committed.load(std::memory_order_acquire);
+            for (std::size_t i = 0; i < count; ++i) visit(c->events[i]);
+        }
+    }
+
+    const std::uint32_t thread_id;
+    std::atomic<std::size_t> dropped = 0;
+
+private:
+    const std::unique_ptr<chunk> first = std::make_unique<chunk>();
+    chunk* last = first.get();  // owner thread only
+    std::size_t chunks = 1;     // owner thread only
+};
+
+// Zone timestamps. On x86-64 the time stamp counter is read directly, which is cheaper than a steady_clock call,
+// and the ticks are converted to nanoseconds on export. Elsewhere a tick is a steady_clock nanosecond.
+inline std::uint64_t trace_ticks()
+{
+#if defined(TRACE_TSC)
+    return __rdtsc();
+#else
+    return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+}
+
+// Every buffer ever created. Buffers outlive their threads, so the exporter can still read them.
+struct trace_registry
+{
+    std::mutex mutex;
+    std::vector<std::unique_ptr<trace_buffer>> buffers;
+    // both clocks read at the same moment, export uses them to convert ticks to nanoseconds
+    const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+    const std::uint64_t epoch_ticks = trace_ticks();
+
+    static trace_registry& instance()
+    {
+        static trace_registry registry;
+        return registry;
+    }
+};
+
+// The registry lock is taken once per thread, the first time it records something.
+inline trace_buffer& this_thread_trace_buffer()
+{
+    thread_local trace_buffer* buffer = []
+    {
+        auto& registry = trace_registry::instance();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        const auto thread_id = static_cast<std::uint32_t>(registry.buffers.size() + 1);
+        return registry.buffers.emplace_back(std::make_unique<trace_buffer>(thread_id)).get();
+    }();
+    return *buffer;
+}
+
+class trace_zone
+{
+public:
+    // The buffer is looked up first, so the registry epoch is never later than a zone start.
+    explicit trace_zone(const char* aName) : buffer(this_thread_trace_buffer()), name(aName), begin(trace_ticks()) { }
+    // Records into the given buffer instead, which may be one that is not registered and is never exported.
+    trace_zone(trace_buffer& aBuffer, const char* aName) : buffer(aBuffer), name(aName), begin(trace_ticks()) { }
+    ~trace_zone() { buffer.record(name, begin, trace_ticks()); }
+    trace_zone(const trace_zone&) = delete;
+    trace_zone& operator=(const trace_zone&) = delete;
+
+private:
+    trace_buffer& buffer;
+    const char* name;
+    std::uint64_t begin;
+};
+
+struct trace_export
+{
+    std::size_t written = 0;
+    std::size_t dropped = 0;    // zones not recorded because a buffer reached its limit
+};
+
+// Writes the zones published so far as "complete" (ph X) events, times in microseconds. The dropped zones are also
+// reported in the trace metadata.
+inline trace_export write_chrome_trace(const std::string& path)
+{
+    auto& registry = trace_registry::instance();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+
+    const auto elapsed_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - registry.epoch);
+    const auto ns_per_tick = elapsed_ns.count() / static_cast<double>(trace_ticks() - registry.epoch_ticks);
+    const auto us = [&](const std::uint64_t ticks) { return static_cast<double>(ticks) * ns_per_tick / 1000.0; };
+
+    std::ofstream out(path);
+    out << std::fixed << std::setprecision(3);
+    trace_export result;
+    out << "{\"traceEvents\":[\n";
+    for (const auto& buffer : registry.buffers)
+    {
+        result.dropped += buffer->dropped.load(std::memory_order_relaxed);
+        buffer->for_each([&](const trace_event& event)
+        {
+            out << (result.written++ ? ",\n" : "") << R"({"name":")" << event.name << R"(","ph":"X","pid":1,"tid":)"
+                << buffer->thread_id << ",\"ts\":" << us(event.begin - registry.epoch_ticks)
+                << ",\"dur\":" << us(event.end - event.begin) << '}';
+        });
+    }
+    out << "\n],\"displayTimeUnit\":\"ns\",\"otherData\":{\"dropped_zones\":" << result.dropped << "}}\n";
+    return result;
+}
+
+#endif //TRACING_H
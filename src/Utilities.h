@@ -5,13 +5,20 @@
 #ifndef UTILITIES_H
 #define UTILITIES_H
 
+#include <chrono>
+#include <cstddef>
 #include <iostream>
+#include <memory>
 #include <sstream>
 #include <string>
+#include <string_view>
+#include <utility>
+#include "Symbols.h"
 
 struct Dummy
 {
-    explicit Dummy(const std::string& aId) : id(aId)
+    // the id is interned, copies of it compare and hash as a pointer
+    explicit Dummy(const std::string_view aId) : id(intern(aId))
     {
         std::cout << "constructing Dummy object id=" << aId << '\n';
     }
@@ -19,7 +26,7 @@ struct Dummy
     {
         std::cout << "destroying Dummy object id=" << id << '\n';
     }
-    std::string id;
+    symbol id;
 };
 
 // C++20 concept
@@ -53,4 +60,57 @@ std::string format_array(const T(&array)[N])
     return os.str();
 }
 
+// Wall clock time spent running a callable. Used by the benchmark sections.
+template <typename Callable>
+std::chrono::nanoseconds measure(Callable&& callable)
+{
+    const auto start = std::chrono::steady_clock::now();
+    std::forward<Callable>(callable)();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+}
+
+// Milliseconds with a fraction, to print a measure() result.
+inline double to_ms(const std::chrono::nanoseconds elapsed)
+{
+    return static_cast<double>(elapsed.count()) / 1e6;
+}
+
+// Keeps a benchmark result alive so the optimizer cannot remove the code that produced it.
+template <typename T>
+void do_not_optimize(const T& value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static const void* volatile sink;
+    sink = &value;
+#endif
+}
+
+// std::allocator that adds up the bytes it currently has allocated, to measure the memory used by std containers.
+template <typename T>
+struct counting_allocator
+{
+    using value_type = T;
+
+    explicit counting_allocator(std::size_t& aBytes) : bytes(&aBytes) { }
+    template <typename U>
+    counting_allocator(const counting_allocator<U>& other) : bytes(other.bytes) { }
+
+    T* allocate(const std::size_t n)
+    {
+        *bytes += n * sizeof(T);
+        return std::allocator<T>{}.allocate(n);
+    }
+    void deallocate(T* p, const std::size_t n)
+    {
+        *bytes -= n * sizeof(T);
+        std::allocator<T>{}.deallocate(p, n);
+    }
+    template <typename U>
+    bool operator==(const counting_allocator<U>& other) const { return bytes == other.bytes; }
+
+    std::size_t* bytes;
+};
+
 #endif //UTILITIES_H
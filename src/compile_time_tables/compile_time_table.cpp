@@ -0,0 +1,48 @@
+// (c) 2025 Patricio Palma (ppalma.dev AT protonmail.com)
+//
+// Builds one table of CompileTimeTables.h, picked at build time, in the compiler with CONSTANT_EVALUATION or at
+// startup without it. The build only times the compiler front end on this file, the difference between the two is
+// what the table costs the compiler. See compile_time_tables() in Cpp20Features.h.
+
+#include <cstdio>
+#include "../CompileTimeTables.h"
+
+int main()
+{
+#if defined(TABLE_CRC32)
+#if defined(CONSTANT_EVALUATION)
+    static constexpr auto table = make_crc32_table(0xEDB88320u);
+#else
+    volatile std::uint32_t polynomial = 0xEDB88320u;
+    const auto table = make_crc32_table(polynomial);
+#endif
+    std::printf("%08x\n", static_cast<unsigned>(table[1]));
+#elif defined(TABLE_SORTED_KEYWORDS)
+#if defined(CONSTANT_EVALUATION)
+    static constexpr auto table = sorted_keywords();
+#else
+    auto table = keywords;
+    std::ranges::sort(table);
+#endif
+    std::printf("%.*s\n", static_cast<int>(table[0].size()), table[0].data());
+#elif defined(TABLE_PERFECT_HASH)
+#if defined(CONSTANT_EVALUATION)
+    static constexpr auto table = perfect_keyword_table();
+#else
+    volatile std::uint32_t first_seed = 0;
+    const auto table = find_perfect_keyword_table(first_seed);
+#endif
+    std::printf("%u\n", static_cast<unsigned>(table.seed));
+#elif defined(TABLE_PRIMES)
+#if defined(CONSTANT_EVALUATION)
+    static constexpr auto table = prime_table();
+#else
+    volatile int limit = prime_limit;
+    const auto table = primes_below(limit);
+#endif
+    std::printf("%zu\n", table.size());
+#else
+#error "define one TABLE_*"
+#endif
+    return 0;
+}
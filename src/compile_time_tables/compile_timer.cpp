@@ -0,0 +1,48 @@
+// (c) 2025 Patricio Palma (ppalma.dev AT protonmail.com)
+//
+// compile_timer <output> <runs> <command...>
+// Runs the command the given number of times and writes the fastest and the slowest wall time, in milliseconds, to
+// the output file. Fails as soon as the command does, or when the output cannot be written. The build uses it to time the compile_time_table sources.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+
+int main(int argc, char* argv[])
+{
+    if (argc < 4)
+    {
+        std::fprintf(stderr, "usage: %s <output> <runs> <command...>\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    std::string command;
+    for (int i = 3; i < argc; ++i)
+    {
+        command.append(command.empty() ? "\"" : " \"").append(argv[i]).append("\"");
+    }
+#if defined(_WIN32)
+    command = "\"" + command + "\""; // cmd.exe strips the outer quotes
+#endif
+
+    auto fastest = std::chrono::steady_clock::duration::max();
+    auto slowest = std::chrono::steady_clock::duration::zero();
+    for (int run = std::max(1, std::atoi(argv[2])); run > 0; --run)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        if (std::system(command.c_str()) != 0)
+        {
+            std::fprintf(stderr, "compile_timer: failed: %s\n", command.c_str());
+            return EXIT_FAILURE;
+        }
+        const auto elapsed = std::chrono::steady_clock::now() - start;
+        fastest = std::min(fastest, elapsed);
+        slowest = std::max(slowest, elapsed);
+    }
+    std::ofstream output(argv[1]);
+    const auto ms = [](const auto elapsed) { return std::chrono::duration<double, std::milli>(elapsed).count(); };
+    output << ms(fastest) << ' ' << ms(slowest) << '\n';
+    return output ? 0 : EXIT_FAILURE;
+}
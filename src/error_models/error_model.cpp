@@ -0,0 +1,35 @@
+// (c) 2025 Patricio Palma (ppalma.dev AT protonmail.com)
+//
+// Sums the command line arguments that parse as integers, with the error model picked at build time. Only one
+// model is compiled in, so the size of each program is the size of that model. See error_handling_cost() in
+// Cpp23Features.h.
+
+#include <cstdio>
+#include "../ErrorModels.h"
+
+int main(int argc, char* argv[])
+{
+    long long sum = 0;
+    int failures = 0;
+    for (int i = 1; i < argc; ++i)
+    {
+#if defined(ERROR_MODEL_EXCEPTIONS)
+        try { sum += parse_or_throw(argv[i]); }
+        catch (const std::invalid_argument&) { ++failures; }
+#elif defined(ERROR_MODEL_EXPECTED)
+        if (const auto value = parse_expected(argv[i])) sum += *value;
+        else ++failures;
+#elif defined(ERROR_MODEL_OPTIONAL)
+        if (const auto value = parse_optional(argv[i])) sum += *value;
+        else ++failures;
+#elif defined(ERROR_MODEL_ERROR_CODE)
+        int value = 0;
+        if (parse_error_code(argv[i], value) == std::errc{}) sum += value;
+        else ++failures;
+#else
+#error "define one ERROR_MODEL_*"
+#endif
+    }
+    std::printf("sum=%lld failures=%d\n", sum, failures);
+    return 0;
+}
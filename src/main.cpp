@@ -12,10 +12,23 @@
 #include "Cpp20Features.h"
 #include "Cpp23Features.h"
 #include "Cpp26Features.h"
+#include "MemoryHierarchy.h"
+#include "Tracing.h"
 
-int main()
+int main(int argc, char* argv[])
 {
-    Cpp11Features cpp11;
+#if !defined(__OPTIMIZE__) && !defined(NDEBUG)
+    emit("warning: built without optimizations, the benchmark numbers are not meaningful, use a Release build\n");
+#endif
+
+    // Optional thread placement for the threaded sections: os (default), same-cpu, smt or spread.
+    const auto placement = argc > 1 ? thread_placement_from_name(argv[1]) : thread_placement::os_default;
+
+    // First, the other results only make sense against the cache and memory latencies of this machine
+    MemoryHierarchy memory(placement);
+    memory.show_features();
+
+    Cpp11Features cpp11(placement);
     cpp11.show_features();
 
     Cpp14Features cpp14;
@@ -24,14 +37,18 @@ int main()
     Cpp17Features cpp17;
     cpp17.show_features();
 
-    Cpp20Features cpp20;
+    Cpp20Features cpp20(placement);
     cpp20.show_features();
 
-    Cpp23Features cpp23;
+    Cpp23Features cpp23(placement);
     cpp23.show_features();
 
-    // Cpp26Features cpp26;
-    // cpp26.show_features();
+    Cpp26Features cpp26;
+    cpp26.show_features();
+
+    // Timeline of the threaded sections, open it with chrome://tracing or https://ui.perfetto.dev
+    const auto trace = write_chrome_trace("CppFeaturesTestCode.trace.json");
+    emit("{} trace zones written to CppFeaturesTestCode.trace.json, {} dropped\n", trace.written, trace.dropped);
 
     return 0;
 }